@@ -464,8 +464,11 @@
         'callback_unittest.nc',
         'cancelable_callback_unittest.cc',
         'command_line_unittest.cc',
+        'compact_value_unittest.cc',
         'containers/hash_tables_unittest.cc',
         'containers/linked_list_unittest.cc',
+        'containers/lock_free_pointer_ring_unittest.cc',
+        'containers/mpsc_queue_unittest.cc',
         'containers/mru_cache_unittest.cc',
         'containers/small_map_unittest.cc',
         'containers/stack_container_unittest.cc',
@@ -501,8 +504,11 @@
         'i18n/time_formatting_unittest.cc',
         'ini_parser_unittest.cc',
         'ios/device_util_unittest.mm',
+        'json/json_compact_parser_unittest.cc',
+        'json/json_lazy_reader_unittest.cc',
         'json/json_parser_unittest.cc',
         'json/json_reader_unittest.cc',
+        'json/json_structural_index_unittest.cc',
         'json/json_value_converter_unittest.cc',
         'json/json_value_serializer_unittest.cc',
         'json/json_writer_unittest.cc',
@@ -547,6 +553,7 @@
         'observer_list_unittest.cc',
         'os_compat_android_unittest.cc',
         'path_service_unittest.cc',
+        'pending_task_unittest.cc',
         'pickle_unittest.cc',
         'platform_file_unittest.cc',
         'posix/file_descriptor_shuffle_unittest.cc',
@@ -830,6 +837,27 @@
         }],
       ],  # target_conditions
     },
+    {
+      'target_name': 'base_perftests',
+      'type': '<(gtest_target_type)',
+      'dependencies': [
+        'base',
+        'test_support_base',
+        'test_support_perf',
+        '../testing/gtest.gyp:gtest',
+      ],
+      'sources': [
+        'json/json_perftest.cc',
+        'message_loop/message_loop_perftest.cc',
+      ],
+      'conditions': [
+        ['OS == "android" and gtest_target_type == "shared_library"', {
+          'dependencies': [
+            '../testing/android/native_test.gyp:native_test_native_code',
+          ],
+        }],
+      ],
+    },
     {
       'target_name': 'test_support_base',
       'type': 'static_library',
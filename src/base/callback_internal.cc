@@ -4,11 +4,112 @@
 
 #include "base/callback_internal.h"
 
+#include <algorithm>
+#include <new>
+
+#include "base/containers/lock_free_pointer_ring.h"
+#include "base/lazy_instance.h"
 #include "base/logging.h"
+#include "base/third_party/dynamic_annotations/dynamic_annotations.h"
 
 namespace base {
 namespace internal {
 
+namespace {
+
+// Bind states are pooled in size classes of kSizeClassGranularity bytes, up to
+// kNumSizeClasses * kSizeClassGranularity bytes. Larger ones use the heap.
+// Each size class keeps at most kMaxFreeBytesPerSizeClass bytes of free
+// blocks, so the pool holds on to 32 KB at most.
+const size_t kSizeClassGranularity = 16;
+const size_t kNumSizeClasses = 8;
+const size_t kMaxFreeBytesPerSizeClass = 4096;
+
+class BindStatePool {
+ public:
+  BindStatePool() : enabled_(true) {
+#if defined(ADDRESS_SANITIZER)
+    // Recycling blocks would hide use-after-free bugs from the tools.
+    enabled_ = false;
+#endif
+    if (RunningOnValgrind())
+      enabled_ = false;
+    for (size_t i = 0; i < kNumSizeClasses; ++i) {
+      // LockFreePointerRing rounds its capacity up to a power of two, so pick
+      // the largest power of two that stays within the budget.
+      size_t capacity = 1;
+      while (2 * capacity * BlockSize(i) <= kMaxFreeBytesPerSizeClass)
+        capacity *= 2;
+      free_blocks_[i] = new LockFreePointerRing<void>(capacity);
+    }
+  }
+
+  void* Allocate(size_t size) {
+    size_t size_class = SizeClass(size);
+    if (size_class >= kNumSizeClasses)
+      return ::operator new(size);
+    void* block = free_blocks_[size_class]->Pop();
+    if (block)
+      return block;
+    return ::operator new(BlockSize(size_class));
+  }
+
+  void Free(void* block, size_t size) {
+    size_t size_class = SizeClass(size);
+    if (size_class < kNumSizeClasses && enabled_ &&
+        free_blocks_[size_class]->Push(block)) {
+      return;
+    }
+    ::operator delete(block);
+  }
+
+  size_t ReleaseFreeBlocks() {
+    size_t released = 0;
+    for (size_t i = 0; i < kNumSizeClasses; ++i) {
+      while (void* block = free_blocks_[i]->Pop()) {
+        ::operator delete(block);
+        released += BlockSize(i);
+      }
+    }
+    return released;
+  }
+
+ private:
+  static size_t BlockSize(size_t size_class) {
+    return (size_class + 1) * kSizeClassGranularity;
+  }
+
+  static size_t SizeClass(size_t size) {
+    DCHECK_GT(size, 0u);
+    return (size - 1) / kSizeClassGranularity;
+  }
+
+  bool enabled_;
+
+  // Never deleted; the pool is leaky.
+  LockFreePointerRing<void>* free_blocks_[kNumSizeClasses];
+
+  DISALLOW_COPY_AND_ASSIGN(BindStatePool);
+};
+
+LazyInstance<BindStatePool>::Leaky g_bind_state_pool =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+void* BindStateBase::operator new(size_t size) {
+  return g_bind_state_pool.Get().Allocate(size);
+}
+
+void BindStateBase::operator delete(void* block, size_t size) {
+  if (block)
+    g_bind_state_pool.Get().Free(block, size);
+}
+
+size_t BindStateBase::ReleaseFreeBlocks() {
+  return g_bind_state_pool.Get().ReleaseFreeBlocks();
+}
+
 bool CallbackBase::is_null() const {
   return bind_state_.get() == NULL;
 }
@@ -25,6 +126,11 @@ bool CallbackBase::Equals(const CallbackBase& other) const {
          polymorphic_invoke_ == other.polymorphic_invoke_;
 }
 
+void CallbackBase::Swap(CallbackBase* other) {
+  bind_state_.swap(other->bind_state_);
+  std::swap(polymorphic_invoke_, other->polymorphic_invoke_);
+}
+
 CallbackBase::CallbackBase(BindStateBase* bind_state)
     : bind_state_(bind_state),
       polymorphic_invoke_(NULL) {
@@ -27,6 +27,17 @@ namespace internal {
 // us to shield the Callback class from the types of the bound argument via
 // "type erasure."
 class BindStateBase : public RefCountedThreadSafe<BindStateBase> {
+ public:
+  // A BindState is allocated for nearly every posted task. Small ones are
+  // recycled through small lock-free free lists, one per size class, so that
+  // binding a task usually does not hit the heap.
+  BASE_EXPORT static void* operator new(size_t size);
+  BASE_EXPORT static void operator delete(void* block, size_t size);
+
+  // Returns the recycled blocks to the heap, e.g. under memory pressure.
+  // Returns the number of bytes released.
+  BASE_EXPORT static size_t ReleaseFreeBlocks();
+
  protected:
   friend class RefCountedThreadSafe<BindStateBase>;
   virtual ~BindStateBase() {}
@@ -52,6 +63,10 @@ class BASE_EXPORT CallbackBase {
   // Returns true if this callback equals |other|. |other| may be null.
   bool Equals(const CallbackBase& other) const;
 
+  // Exchanges the state of |this| and |other|. Only safe between callbacks of
+  // the same type, which the derived Callback templates enforce.
+  void Swap(CallbackBase* other);
+
   // Allow initializing of |bind_state_| via the constructor to avoid default
   // initialization of the scoped_refptr.  We do not also initialize
   // |polymorphic_invoke_| here because doing a normal assignment in the
@@ -2,6 +2,8 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <vector>
+
 #include "base/bind.h"
 #include "base/callback.h"
 #include "base/callback_helpers.h"
@@ -124,6 +126,37 @@ TEST_F(CallbackTest, Reset) {
   EXPECT_TRUE(callback_a_.Equals(null_callback_));
 }
 
+TEST_F(CallbackTest, Swap) {
+  Callback<void(void)> callback_a2 = callback_a_;
+  Callback<void(void)> callback_c(new FakeBindState1());
+  Callback<void(void)> callback_c2 = callback_c;
+
+  callback_a_.Swap(&callback_c);
+  EXPECT_TRUE(callback_a_.Equals(callback_c2));
+  EXPECT_TRUE(callback_c.Equals(callback_a2));
+
+  // Swapping with a null callback moves the bound state out.
+  callback_a_.Swap(&null_callback_);
+  EXPECT_TRUE(callback_a_.is_null());
+  EXPECT_TRUE(null_callback_.Equals(callback_c2));
+}
+
+void DoNothing(int) {
+}
+
+// The bind state pool only keeps a bounded number of free blocks, and gives
+// them all back when asked to.
+TEST_F(CallbackTest, ReleaseFreeBlocks) {
+  std::vector<Closure> callbacks;
+  for (int i = 0; i < 10000; ++i)
+    callbacks.push_back(Bind(&DoNothing, i));
+  callbacks.clear();
+
+  // Eight size classes of at most 4 KB each.
+  EXPECT_LE(internal::BindStateBase::ReleaseFreeBlocks(), 8u * 4096u);
+  EXPECT_EQ(0u, internal::BindStateBase::ReleaseFreeBlocks());
+}
+
 struct TestForReentrancy {
   TestForReentrancy()
       : cb_already_run(false),
@@ -0,0 +1,431 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/compact_value.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <new>
+
+#include "base/logging.h"
+
+namespace base {
+
+namespace {
+
+// Most documents fit in a handful of blocks; larger requests get a block of
+// their own.
+const size_t kArenaBlockSize = 32 * 1024;
+const size_t kArenaAlignment = 8;
+
+size_t AlignUp(size_t size) {
+  return (size + kArenaAlignment - 1) & ~(kArenaAlignment - 1);
+}
+
+struct EntryKeyLess {
+  bool operator()(const CompactValue::Entry& a,
+                  const CompactValue::Entry& b) const {
+    return a.key() < b.key();
+  }
+  bool operator()(const CompactValue::Entry& a, const StringPiece& b) const {
+    return a.key() < b;
+  }
+  bool operator()(const StringPiece& a, const CompactValue::Entry& b) const {
+    return a < b.key();
+  }
+};
+
+}  // namespace
+
+CompactValueArena::CompactValueArena()
+    : next_(NULL),
+      remaining_(0),
+      bytes_allocated_(0),
+      bytes_reserved_(0) {
+}
+
+CompactValueArena::~CompactValueArena() {
+  for (size_t i = 0; i < blocks_.size(); ++i)
+    delete[] blocks_[i];
+}
+
+void* CompactValueArena::Allocate(size_t size) {
+  size = AlignUp(size);
+  bytes_allocated_ += size;
+  if (size > remaining_) {
+    if (size > kArenaBlockSize / 4) {
+      // Keep the current block for the small allocations that follow.
+      char* block = new char[size];
+      blocks_.push_back(block);
+      bytes_reserved_ += size;
+      return block;
+    }
+    next_ = new char[kArenaBlockSize];
+    blocks_.push_back(next_);
+    remaining_ = kArenaBlockSize;
+    bytes_reserved_ += kArenaBlockSize;
+  }
+  void* result = next_;
+  next_ += size;
+  remaining_ -= size;
+  return result;
+}
+
+const char* CompactValueArena::CopyString(const StringPiece& str) {
+  if (str.empty())
+    return NULL;
+  char* copy = static_cast<char*>(Allocate(str.size()));
+  memcpy(copy, str.data(), str.size());
+  return copy;
+}
+
+// static
+CompactValue* CompactValue::FromValue(const Value& value,
+                                      CompactValueArena* arena) {
+  CompactValue* result =
+      new (arena->Allocate(sizeof(CompactValue))) CompactValue;
+  result->InitFromValue(value, arena);
+  return result;
+}
+
+CompactValue::CompactValue() : type_(Value::TYPE_NULL), size_(0) {
+  data_.items = NULL;
+}
+
+bool CompactValue::GetAsBoolean(bool* out_value) const {
+  if (type_ != Value::TYPE_BOOLEAN)
+    return false;
+  if (out_value)
+    *out_value = data_.boolean;
+  return true;
+}
+
+bool CompactValue::GetAsInteger(int* out_value) const {
+  if (type_ != Value::TYPE_INTEGER)
+    return false;
+  if (out_value)
+    *out_value = data_.integer;
+  return true;
+}
+
+bool CompactValue::GetAsDouble(double* out_value) const {
+  if (type_ == Value::TYPE_INTEGER) {
+    if (out_value)
+      *out_value = data_.integer;
+    return true;
+  }
+  if (type_ != Value::TYPE_DOUBLE)
+    return false;
+  if (out_value)
+    *out_value = data_.real;
+  return true;
+}
+
+bool CompactValue::GetAsString(std::string* out_value) const {
+  if (type_ != Value::TYPE_STRING)
+    return false;
+  if (out_value)
+    out_value->assign(bytes(), size_);
+  return true;
+}
+
+bool CompactValue::GetAsString(StringPiece* out_value) const {
+  if (type_ != Value::TYPE_STRING)
+    return false;
+  if (out_value)
+    out_value->set(bytes(), size_);
+  return true;
+}
+
+bool CompactValue::GetAsBinary(StringPiece* out_value) const {
+  if (type_ != Value::TYPE_BINARY)
+    return false;
+  if (out_value)
+    out_value->set(bytes(), size_);
+  return true;
+}
+
+size_t CompactValue::size() const {
+  if (type_ != Value::TYPE_LIST && type_ != Value::TYPE_DICTIONARY)
+    return 0;
+  return size_;
+}
+
+const CompactValue* CompactValue::GetListItem(size_t index) const {
+  if (type_ != Value::TYPE_LIST || index >= size_)
+    return NULL;
+  return &data_.items[index];
+}
+
+const CompactValue::Entry* CompactValue::GetDictionaryEntry(
+    size_t index) const {
+  if (type_ != Value::TYPE_DICTIONARY || index >= size_)
+    return NULL;
+  return &data_.entries[index];
+}
+
+const CompactValue* CompactValue::FindKey(const StringPiece& key) const {
+  if (type_ != Value::TYPE_DICTIONARY)
+    return NULL;
+  const Entry* begin = data_.entries;
+  const Entry* end = begin + size_;
+  const Entry* entry = std::lower_bound(begin, end, key, EntryKeyLess());
+  if (entry == end || entry->key() != key)
+    return NULL;
+  return &entry->value;
+}
+
+void CompactValue::SetNull() {
+  type_ = Value::TYPE_NULL;
+  size_ = 0;
+  data_.items = NULL;
+}
+
+void CompactValue::SetBoolean(bool value) {
+  type_ = Value::TYPE_BOOLEAN;
+  size_ = 0;
+  data_.boolean = value;
+}
+
+void CompactValue::SetInteger(int value) {
+  type_ = Value::TYPE_INTEGER;
+  size_ = 0;
+  data_.integer = value;
+}
+
+void CompactValue::SetDouble(double value) {
+  type_ = Value::TYPE_DOUBLE;
+  size_ = 0;
+  data_.real = value;
+}
+
+void CompactValue::SetString(const StringPiece& value,
+                             CompactValueArena* arena) {
+  type_ = Value::TYPE_STRING;
+  SetBytes(value, arena);
+}
+
+void CompactValue::SetBinary(const StringPiece& data,
+                             CompactValueArena* arena) {
+  type_ = Value::TYPE_BINARY;
+  SetBytes(data, arena);
+}
+
+CompactValue* CompactValue::SetList(size_t size, CompactValueArena* arena) {
+  CHECK_LE(size, kuint32max / sizeof(CompactValue));
+  type_ = Value::TYPE_LIST;
+  size_ = static_cast<uint32>(size);
+  data_.items = NULL;
+  if (size) {
+    data_.items = static_cast<CompactValue*>(
+        arena->Allocate(size * sizeof(CompactValue)));
+    for (size_t i = 0; i < size; ++i)
+      new (&data_.items[i]) CompactValue;
+  }
+  return data_.items;
+}
+
+CompactValue::Entry* CompactValue::SetDictionary(size_t size,
+                                                 CompactValueArena* arena) {
+  CHECK_LE(size, kuint32max / sizeof(Entry));
+  type_ = Value::TYPE_DICTIONARY;
+  size_ = static_cast<uint32>(size);
+  data_.entries = NULL;
+  if (size) {
+    data_.entries = static_cast<Entry*>(arena->Allocate(size * sizeof(Entry)));
+    for (size_t i = 0; i < size; ++i) {
+      Entry* entry = new (&data_.entries[i]) Entry;
+      entry->key_data = NULL;
+      entry->key_size = 0;
+    }
+  }
+  return data_.entries;
+}
+
+void CompactValue::FinishDictionary() {
+  DCHECK_EQ(Value::TYPE_DICTIONARY, type_);
+  Entry* begin = data_.entries;
+  Entry* end = begin + size_;
+  EntryKeyLess less;
+
+  // Input that is already sorted without duplicates, such as a converted
+  // DictionaryValue, needs no work.
+  bool sorted = true;
+  for (Entry* entry = begin; entry + 1 < end && sorted; ++entry)
+    sorted = less(*entry, *(entry + 1));
+  if (sorted)
+    return;
+
+  std::stable_sort(begin, end, less);
+  // Keep the last of each run of equal keys.
+  Entry* out = begin;
+  for (Entry* entry = begin; entry != end; ++entry) {
+    if (entry + 1 != end && entry->key() == (entry + 1)->key())
+      continue;
+    *out++ = *entry;
+  }
+  size_ = static_cast<uint32>(out - begin);
+}
+
+bool CompactValue::Equals(const CompactValue& other) const {
+  if (type_ != other.type_)
+    return false;
+  switch (type_) {
+    case Value::TYPE_NULL:
+      return true;
+    case Value::TYPE_BOOLEAN:
+      return data_.boolean == other.data_.boolean;
+    case Value::TYPE_INTEGER:
+      return data_.integer == other.data_.integer;
+    case Value::TYPE_DOUBLE:
+      return data_.real == other.data_.real;
+    case Value::TYPE_STRING:
+    case Value::TYPE_BINARY:
+      return StringPiece(bytes(), size_) ==
+          StringPiece(other.bytes(), other.size_);
+    case Value::TYPE_LIST:
+      if (size_ != other.size_)
+        return false;
+      for (size_t i = 0; i < size_; ++i) {
+        if (!data_.items[i].Equals(other.data_.items[i]))
+          return false;
+      }
+      return true;
+    case Value::TYPE_DICTIONARY:
+      if (size_ != other.size_)
+        return false;
+      for (size_t i = 0; i < size_; ++i) {
+        if (data_.entries[i].key() != other.data_.entries[i].key() ||
+            !data_.entries[i].value.Equals(other.data_.entries[i].value)) {
+          return false;
+        }
+      }
+      return true;
+    default:
+      NOTREACHED();
+      return false;
+  }
+}
+
+Value* CompactValue::ToValue() const {
+  switch (type_) {
+    case Value::TYPE_NULL:
+      return Value::CreateNullValue();
+    case Value::TYPE_BOOLEAN:
+      return new FundamentalValue(data_.boolean);
+    case Value::TYPE_INTEGER:
+      return new FundamentalValue(data_.integer);
+    case Value::TYPE_DOUBLE:
+      return new FundamentalValue(data_.real);
+    case Value::TYPE_STRING:
+      return new StringValue(std::string(bytes(), size_));
+    case Value::TYPE_BINARY:
+      return BinaryValue::CreateWithCopiedBuffer(bytes(), size_);
+    case Value::TYPE_LIST: {
+      ListValue* list = new ListValue;
+      for (size_t i = 0; i < size_; ++i)
+        list->Append(data_.items[i].ToValue());
+      return list;
+    }
+    case Value::TYPE_DICTIONARY: {
+      DictionaryValue* dict = new DictionaryValue;
+      for (size_t i = 0; i < size_; ++i) {
+        const Entry& entry = data_.entries[i];
+        dict->SetWithoutPathExpansion(entry.key().as_string(),
+                                      entry.value.ToValue());
+      }
+      return dict;
+    }
+    default:
+      NOTREACHED();
+      return NULL;
+  }
+}
+
+const char* CompactValue::bytes() const {
+  return size_ <= sizeof(data_.inline_chars) ? data_.inline_chars :
+      data_.chars;
+}
+
+void CompactValue::SetBytes(const StringPiece& bytes,
+                            CompactValueArena* arena) {
+  CHECK_LE(bytes.size(), kuint32max);
+  size_ = static_cast<uint32>(bytes.size());
+  if (bytes.size() <= sizeof(data_.inline_chars))
+    memcpy(data_.inline_chars, bytes.data(), bytes.size());
+  else
+    data_.chars = arena->CopyString(bytes);
+}
+
+void CompactValue::InitFromValue(const Value& value,
+                                 CompactValueArena* arena) {
+  switch (value.GetType()) {
+    case Value::TYPE_NULL:
+      SetNull();
+      break;
+    case Value::TYPE_BOOLEAN: {
+      bool boolean = false;
+      value.GetAsBoolean(&boolean);
+      SetBoolean(boolean);
+      break;
+    }
+    case Value::TYPE_INTEGER: {
+      int integer = 0;
+      value.GetAsInteger(&integer);
+      SetInteger(integer);
+      break;
+    }
+    case Value::TYPE_DOUBLE: {
+      double real = 0;
+      value.GetAsDouble(&real);
+      SetDouble(real);
+      break;
+    }
+    case Value::TYPE_STRING: {
+      std::string str;
+      value.GetAsString(&str);
+      SetString(str, arena);
+      break;
+    }
+    case Value::TYPE_BINARY: {
+      const BinaryValue& binary = static_cast<const BinaryValue&>(value);
+      SetBinary(StringPiece(binary.GetBuffer(), binary.GetSize()), arena);
+      break;
+    }
+    case Value::TYPE_LIST: {
+      const ListValue& list = static_cast<const ListValue&>(value);
+      CompactValue* items = SetList(list.GetSize(), arena);
+      for (size_t i = 0; i < list.GetSize(); ++i) {
+        const Value* item = NULL;
+        list.Get(i, &item);
+        items[i].InitFromValue(*item, arena);
+      }
+      break;
+    }
+    case Value::TYPE_DICTIONARY: {
+      const DictionaryValue& dict = static_cast<const DictionaryValue&>(value);
+      Entry* entry = SetDictionary(dict.size(), arena);
+      for (DictionaryValue::Iterator it(dict); !it.IsAtEnd(); it.Advance()) {
+        entry->SetKey(it.key(), arena);
+        entry->value.InitFromValue(it.value(), arena);
+        ++entry;
+      }
+      // DictionaryValue iterates in key order, so this does not move anything.
+      FinishDictionary();
+      break;
+    }
+    default:
+      NOTREACHED();
+  }
+}
+
+void CompactValue::Entry::SetKey(const StringPiece& key,
+                                 CompactValueArena* arena) {
+  CHECK_LE(key.size(), kuint32max);
+  key_data = arena->CopyString(key);
+  key_size = static_cast<uint32>(key.size());
+}
+
+}  // namespace base
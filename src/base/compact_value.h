@@ -0,0 +1,178 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// CompactValue is a memory-efficient alternative to base::Value for large,
+// mostly read-only trees such as parsed JSON documents.
+//
+// Every Value lives in its own heap allocation, and every DictionaryValue
+// entry adds a std::map node and a std::string on top of that. CompactValue
+// nodes are 16 bytes of plain data and never own anything:
+//  - scalars and strings of up to 8 bytes are stored inline in the node,
+//  - strings, lists and dictionaries point to contiguous arrays, and
+//  - dictionaries are arrays of (key, value) entries sorted by key, so
+//    lookups are binary searches.
+// All of those arrays live in a CompactValueArena and are released together
+// when the arena is destroyed.
+//
+// Usage:
+//   CompactValueArena arena;
+//   const CompactValue* root =
+//       JSONReader::ReadCompact(json, JSON_PARSE_RFC, &arena, NULL);
+//   if (root) {
+//     const CompactValue* name = root->FindKey("name");
+//     ...
+//   }
+//
+// Use CompactValue::FromValue() and ToValue() to convert from and to
+// base::Value, and JSONWriter::WriteCompact() to serialize.
+
+#ifndef BASE_COMPACT_VALUE_H_
+#define BASE_COMPACT_VALUE_H_
+
+#include <string>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/strings/string_piece.h"
+#include "base/values.h"
+
+namespace base {
+
+// A bump allocator for CompactValue trees. Memory is only returned to the
+// heap when the arena is destroyed. Not thread-safe.
+class BASE_EXPORT CompactValueArena {
+ public:
+  CompactValueArena();
+  ~CompactValueArena();
+
+  // Returns |size| bytes, aligned for any CompactValue field.
+  void* Allocate(size_t size);
+
+  // Copies |str| into the arena and returns the copy.
+  const char* CopyString(const StringPiece& str);
+
+  // Bytes handed out by Allocate(), including alignment padding.
+  size_t bytes_allocated() const { return bytes_allocated_; }
+
+  // Bytes obtained from the heap.
+  size_t bytes_reserved() const { return bytes_reserved_; }
+
+ private:
+  std::vector<char*> blocks_;
+  char* next_;
+  size_t remaining_;
+  size_t bytes_allocated_;
+  size_t bytes_reserved_;
+
+  DISALLOW_COPY_AND_ASSIGN(CompactValueArena);
+};
+
+class BASE_EXPORT CompactValue {
+ public:
+  struct Entry;
+
+  // Converts |value| and all of its children. The result and everything it
+  // refers to are allocated in |arena|.
+  static CompactValue* FromValue(const Value& value, CompactValueArena* arena);
+
+  // Creates a null value. CompactValues are plain data and are usually
+  // created in an arena, either by FromValue() or as the elements returned by
+  // SetList() and SetDictionary().
+  CompactValue();
+
+  Value::Type GetType() const { return static_cast<Value::Type>(type_); }
+  bool IsType(Value::Type type) const { return GetType() == type; }
+
+  // These behave like their base::Value counterparts. GetAsDouble() converts
+  // integers.
+  bool GetAsBoolean(bool* out_value) const;
+  bool GetAsInteger(int* out_value) const;
+  bool GetAsDouble(double* out_value) const;
+  bool GetAsString(std::string* out_value) const;
+  bool GetAsString(StringPiece* out_value) const;
+  bool GetAsBinary(StringPiece* out_value) const;
+
+  // Returns the number of elements of a list or entries of a dictionary, and
+  // zero for all other types.
+  size_t size() const;
+
+  // Returns the list element at |index|, or NULL if this is not a list or
+  // |index| is out of range.
+  const CompactValue* GetListItem(size_t index) const;
+
+  // Returns the dictionary entry at |index|, in ascending key order, or NULL
+  // if this is not a dictionary or |index| is out of range.
+  const Entry* GetDictionaryEntry(size_t index) const;
+
+  // Looks up |key| in a dictionary without path expansion. Returns NULL if
+  // this is not a dictionary or the key is missing.
+  const CompactValue* FindKey(const StringPiece& key) const;
+
+  void SetNull();
+  void SetBoolean(bool value);
+  void SetInteger(int value);
+  void SetDouble(double value);
+  // The bytes are copied into |arena|.
+  void SetString(const StringPiece& value, CompactValueArena* arena);
+  void SetBinary(const StringPiece& data, CompactValueArena* arena);
+
+  // Makes this a list of |size| null values, allocated in |arena|, and
+  // returns the first of them for the caller to fill in.
+  CompactValue* SetList(size_t size, CompactValueArena* arena);
+
+  // Makes this a dictionary with room for |size| entries, allocated in
+  // |arena|, and returns the first of them. The caller must give every entry
+  // a key and then call FinishDictionary() before the dictionary is used.
+  Entry* SetDictionary(size_t size, CompactValueArena* arena);
+
+  // Sorts the entries of a dictionary by key. When a key appears more than
+  // once, the entry that was filled in last wins, as with
+  // DictionaryValue::SetWithoutPathExpansion().
+  void FinishDictionary();
+
+  // Deep comparison.
+  bool Equals(const CompactValue& other) const;
+
+  // Converts this value and all of its children. The caller owns the result.
+  Value* ToValue() const;
+
+ private:
+  // Returns the bytes of a string or binary value.
+  const char* bytes() const;
+
+  // Stores |bytes| inline if they fit, in |arena| otherwise, and sets size_.
+  void SetBytes(const StringPiece& bytes, CompactValueArena* arena);
+
+  void InitFromValue(const Value& value, CompactValueArena* arena);
+
+  uint8 type_;
+  // Length of a string or binary value, number of list elements or
+  // dictionary entries.
+  uint32 size_;
+  union {
+    bool boolean;
+    int integer;
+    double real;
+    const char* chars;
+    char inline_chars[8];
+    CompactValue* items;
+    Entry* entries;
+  } data_;
+};
+
+struct BASE_EXPORT CompactValue::Entry {
+  StringPiece key() const { return StringPiece(key_data, key_size); }
+
+  // The bytes are copied into |arena|.
+  void SetKey(const StringPiece& key, CompactValueArena* arena);
+
+  const char* key_data;
+  uint32 key_size;
+  CompactValue value;
+};
+
+}  // namespace base
+
+#endif  // BASE_COMPACT_VALUE_H_
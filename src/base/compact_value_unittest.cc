@@ -0,0 +1,156 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/compact_value.h"
+
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/stringprintf.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+TEST(CompactValueTest, Size) {
+  // Scalars must stay inline; see the comment in compact_value.h.
+  EXPECT_LE(sizeof(CompactValue), 16u);
+}
+
+TEST(CompactValueTest, Scalars) {
+  CompactValueArena arena;
+  CompactValue value;
+  EXPECT_TRUE(value.IsType(Value::TYPE_NULL));
+
+  value.SetBoolean(true);
+  bool boolean = false;
+  EXPECT_TRUE(value.GetAsBoolean(&boolean));
+  EXPECT_TRUE(boolean);
+  EXPECT_FALSE(value.GetAsInteger(NULL));
+
+  value.SetInteger(-12);
+  int integer = 0;
+  double real = 0;
+  EXPECT_TRUE(value.GetAsInteger(&integer));
+  EXPECT_EQ(-12, integer);
+  EXPECT_TRUE(value.GetAsDouble(&real));
+  EXPECT_EQ(-12.0, real);
+
+  value.SetDouble(2.5);
+  EXPECT_FALSE(value.GetAsInteger(&integer));
+  EXPECT_TRUE(value.GetAsDouble(&real));
+  EXPECT_EQ(2.5, real);
+
+  std::string input("a string");
+  value.SetString(input, &arena);
+  input[0] = 'X';
+  std::string str;
+  EXPECT_TRUE(value.GetAsString(&str));
+  EXPECT_EQ("a string", str);
+  StringPiece piece;
+  EXPECT_TRUE(value.GetAsString(&piece));
+  EXPECT_EQ("a string", piece.as_string());
+  EXPECT_FALSE(value.GetAsBinary(&piece));
+
+  value.SetString(StringPiece(), &arena);
+  EXPECT_TRUE(value.GetAsString(&str));
+  EXPECT_EQ("", str);
+  EXPECT_EQ(0u, value.size());
+}
+
+TEST(CompactValueTest, ListAndDictionary) {
+  CompactValueArena arena;
+  CompactValue list;
+  CompactValue* items = list.SetList(3, &arena);
+  items[0].SetInteger(1);
+  CompactValue::Entry* entries = items[1].SetDictionary(4, &arena);
+  entries[0].SetKey("b", &arena);
+  entries[0].value.SetInteger(2);
+  entries[1].SetKey("a", &arena);
+  entries[1].value.SetInteger(1);
+  entries[2].SetKey("b", &arena);
+  entries[2].value.SetInteger(3);
+  entries[3].SetKey("", &arena);
+  items[1].FinishDictionary();
+
+  EXPECT_EQ(3u, list.size());
+  EXPECT_TRUE(list.GetListItem(2)->IsType(Value::TYPE_NULL));
+  EXPECT_FALSE(list.GetListItem(3));
+  EXPECT_FALSE(list.FindKey("a"));
+
+  const CompactValue* dict = list.GetListItem(1);
+  // The duplicate key collapses, keeping the last value.
+  ASSERT_EQ(3u, dict->size());
+  EXPECT_EQ("", dict->GetDictionaryEntry(0)->key().as_string());
+  EXPECT_EQ("a", dict->GetDictionaryEntry(1)->key().as_string());
+  EXPECT_EQ("b", dict->GetDictionaryEntry(2)->key().as_string());
+  EXPECT_FALSE(dict->GetDictionaryEntry(3));
+
+  int integer = 0;
+  ASSERT_TRUE(dict->FindKey("b"));
+  EXPECT_TRUE(dict->FindKey("b")->GetAsInteger(&integer));
+  EXPECT_EQ(3, integer);
+  ASSERT_TRUE(dict->FindKey(""));
+  EXPECT_FALSE(dict->FindKey("c"));
+  EXPECT_FALSE(dict->FindKey("aa"));
+}
+
+TEST(CompactValueTest, RoundTrip) {
+  DictionaryValue original;
+  original.SetBoolean("bool", false);
+  original.SetInteger("int", 42);
+  original.SetDouble("double", 3.25);
+  original.SetString("string", "hello");
+  original.Set("null", Value::CreateNullValue());
+  original.Set("binary", BinaryValue::CreateWithCopiedBuffer("\0\1\2", 3));
+  ListValue* list = new ListValue;
+  list->AppendInteger(1);
+  list->AppendString("two");
+  list->Append(new DictionaryValue);
+  list->Append(new ListValue);
+  original.Set("list", list);
+  original.SetString("nested.key", "value");
+
+  CompactValueArena arena;
+  CompactValue* compact = CompactValue::FromValue(original, &arena);
+  ASSERT_TRUE(compact);
+  EXPECT_TRUE(compact->IsType(Value::TYPE_DICTIONARY));
+  EXPECT_EQ(original.size(), compact->size());
+  ASSERT_TRUE(compact->FindKey("nested"));
+  EXPECT_TRUE(compact->FindKey("nested")->FindKey("key"));
+
+  StringPiece binary;
+  ASSERT_TRUE(compact->FindKey("binary"));
+  EXPECT_TRUE(compact->FindKey("binary")->GetAsBinary(&binary));
+  EXPECT_EQ(std::string("\0\1\2", 3), binary.as_string());
+
+  scoped_ptr<Value> converted(compact->ToValue());
+  EXPECT_TRUE(original.Equals(converted.get()));
+
+  CompactValue* again = CompactValue::FromValue(*converted, &arena);
+  EXPECT_TRUE(compact->Equals(*again));
+  CompactValue* other = CompactValue::FromValue(*list, &arena);
+  EXPECT_FALSE(compact->Equals(*other));
+}
+
+TEST(CompactValueTest, ArenaGrowsForLargeTrees) {
+  const int kEntries = 10000;
+  DictionaryValue dict;
+  for (int i = 0; i < kEntries; ++i)
+    dict.SetIntegerWithoutPathExpansion(StringPrintf("key%05d", i), i);
+
+  CompactValueArena arena;
+  CompactValue* compact = CompactValue::FromValue(dict, &arena);
+  ASSERT_EQ(static_cast<size_t>(kEntries), compact->size());
+  for (int i = 0; i < kEntries; i += 97) {
+    const CompactValue* value = compact->FindKey(StringPrintf("key%05d", i));
+    int integer = -1;
+    ASSERT_TRUE(value);
+    EXPECT_TRUE(value->GetAsInteger(&integer));
+    EXPECT_EQ(i, integer);
+  }
+  EXPECT_GE(arena.bytes_reserved(), arena.bytes_allocated());
+  EXPECT_GE(arena.bytes_allocated(),
+            kEntries * sizeof(CompactValue::Entry) + kEntries * 8);
+}
+
+}  // namespace base
@@ -0,0 +1,128 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// LockFreePointerRing is a bounded, lock-free, multi-producer multi-consumer
+// FIFO of pointers, after Dmitry Vyukov's bounded MPMC queue. Every cell
+// carries a sequence number that tells producers and consumers whose turn it
+// is, which makes the ring immune to the ABA problem that a lock-free stack
+// has. It is meant for free lists that are filled and drained from arbitrary
+// threads; the ring never owns the pointers it holds.
+//
+// While another thread is halfway through an operation on the same cell, Push()
+// may report the ring as full and Pop() may report it as empty. Callers must
+// treat both as hints (allocate or free instead), which is what a free list
+// does anyway.
+
+#ifndef BASE_CONTAINERS_LOCK_FREE_POINTER_RING_H_
+#define BASE_CONTAINERS_LOCK_FREE_POINTER_RING_H_
+
+#include "base/atomicops.h"
+#include "base/basictypes.h"
+
+namespace base {
+
+template <class T>
+class LockFreePointerRing {
+ public:
+  // |capacity| is rounded up to a power of two.
+  explicit LockFreePointerRing(size_t capacity)
+      : mask_(RoundUpToPowerOfTwo(capacity) - 1),
+        cells_(new Cell[mask_ + 1]),
+        push_pos_(0),
+        pop_pos_(0) {
+    for (size_t i = 0; i <= mask_; ++i) {
+      cells_[i].sequence = static_cast<subtle::Atomic32>(i);
+      cells_[i].pointer = NULL;
+    }
+  }
+
+  ~LockFreePointerRing() {
+    delete[] cells_;
+  }
+
+  size_t capacity() const { return mask_ + 1; }
+
+  // Appends |pointer|. Returns false if the ring is full.
+  bool Push(T* pointer) {
+    subtle::Atomic32 pos = subtle::NoBarrier_Load(&push_pos_);
+    Cell* cell;
+    for (;;) {
+      cell = &cells_[static_cast<uint32>(pos) & mask_];
+      int32 diff = Distance(subtle::Acquire_Load(&cell->sequence), pos);
+      if (diff == 0) {
+        subtle::Atomic32 previous = subtle::NoBarrier_CompareAndSwap(
+            &push_pos_, pos, Next(pos, 1));
+        if (previous == pos)
+          break;
+        pos = previous;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = subtle::NoBarrier_Load(&push_pos_);
+      }
+    }
+    cell->pointer = pointer;
+    subtle::Release_Store(&cell->sequence, Next(pos, 1));
+    return true;
+  }
+
+  // Removes and returns the oldest pointer, or NULL if the ring is empty.
+  T* Pop() {
+    subtle::Atomic32 pos = subtle::NoBarrier_Load(&pop_pos_);
+    Cell* cell;
+    for (;;) {
+      cell = &cells_[static_cast<uint32>(pos) & mask_];
+      int32 diff = Distance(subtle::Acquire_Load(&cell->sequence),
+                            Next(pos, 1));
+      if (diff == 0) {
+        subtle::Atomic32 previous = subtle::NoBarrier_CompareAndSwap(
+            &pop_pos_, pos, Next(pos, 1));
+        if (previous == pos)
+          break;
+        pos = previous;
+      } else if (diff < 0) {
+        return NULL;
+      } else {
+        pos = subtle::NoBarrier_Load(&pop_pos_);
+      }
+    }
+    T* pointer = cell->pointer;
+    subtle::Release_Store(&cell->sequence,
+                          Next(pos, static_cast<uint32>(mask_ + 1)));
+    return pointer;
+  }
+
+ private:
+  struct Cell {
+    volatile subtle::Atomic32 sequence;
+    T* pointer;
+  };
+
+  static size_t RoundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value)
+      result <<= 1;
+    return result;
+  }
+
+  // Positions are free-running 32-bit counters; do the arithmetic unsigned so
+  // that wrapping around is well defined.
+  static subtle::Atomic32 Next(subtle::Atomic32 pos, uint32 delta) {
+    return static_cast<subtle::Atomic32>(static_cast<uint32>(pos) + delta);
+  }
+  static int32 Distance(subtle::Atomic32 a, subtle::Atomic32 b) {
+    return static_cast<int32>(static_cast<uint32>(a) - static_cast<uint32>(b));
+  }
+
+  const size_t mask_;
+  Cell* const cells_;
+  volatile subtle::Atomic32 push_pos_;
+  volatile subtle::Atomic32 pop_pos_;
+
+  DISALLOW_COPY_AND_ASSIGN(LockFreePointerRing);
+};
+
+}  // namespace base
+
+#endif  // BASE_CONTAINERS_LOCK_FREE_POINTER_RING_H_
@@ -0,0 +1,105 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/containers/lock_free_pointer_ring.h"
+
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/memory/scoped_vector.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace {
+
+TEST(LockFreePointerRingTest, CapacityRoundsUp) {
+  LockFreePointerRing<int> ring(5);
+  EXPECT_EQ(8u, ring.capacity());
+}
+
+TEST(LockFreePointerRingTest, PushPop) {
+  int values[4] = { 0, 1, 2, 3 };
+  LockFreePointerRing<int> ring(4);
+  EXPECT_EQ(NULL, ring.Pop());
+
+  for (int i = 0; i < 4; ++i)
+    EXPECT_TRUE(ring.Push(&values[i]));
+  // Full.
+  EXPECT_FALSE(ring.Push(&values[0]));
+
+  for (int i = 0; i < 4; ++i)
+    EXPECT_EQ(&values[i], ring.Pop());
+  EXPECT_EQ(NULL, ring.Pop());
+
+  // Wrap around a few times.
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(ring.Push(&values[i % 4]));
+    EXPECT_EQ(&values[i % 4], ring.Pop());
+  }
+}
+
+// Every thread repeatedly takes a token out of the ring and puts it back. No
+// token may ever be handed to two threads at once.
+class TokenUser : public DelegateSimpleThread::Delegate {
+ public:
+  TokenUser(LockFreePointerRing<int>* ring, int iterations)
+      : ring_(ring), iterations_(iterations), failures_(0), dropped_(0) {}
+
+  virtual void Run() OVERRIDE {
+    for (int i = 0; i < iterations_; ++i) {
+      int* token = ring_->Pop();
+      if (!token)
+        continue;
+      if (++*token != 1)
+        ++failures_;
+      --*token;
+      // The ring may transiently look full while another thread is in the
+      // middle of popping; the token is dropped then, like a free list would.
+      if (!ring_->Push(token))
+        ++dropped_;
+    }
+  }
+
+  int failures() const { return failures_; }
+  int dropped() const { return dropped_; }
+
+ private:
+  LockFreePointerRing<int>* ring_;
+  int iterations_;
+  int failures_;
+  int dropped_;
+};
+
+TEST(LockFreePointerRingTest, ConcurrentPushPop) {
+  const int kThreads = 4;
+  const int kTokens = 8;
+  std::vector<int> tokens(kTokens, 0);
+  LockFreePointerRing<int> ring(kTokens * 2);
+  for (int i = 0; i < kTokens; ++i)
+    ASSERT_TRUE(ring.Push(&tokens[i]));
+
+  ScopedVector<TokenUser> users;
+  ScopedVector<DelegateSimpleThread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    users.push_back(new TokenUser(&ring, 100000));
+    threads.push_back(new DelegateSimpleThread(users[i], "token_user"));
+    threads[i]->Start();
+  }
+  int dropped = 0;
+  for (int i = 0; i < kThreads; ++i) {
+    threads[i]->Join();
+    EXPECT_EQ(0, users[i]->failures());
+    dropped += users[i]->dropped();
+  }
+
+  // Every token is either back in the ring or was dropped.
+  int remaining = 0;
+  while (ring.Pop())
+    ++remaining;
+  EXPECT_EQ(kTokens, remaining + dropped);
+}
+
+}  // namespace
+}  // namespace base
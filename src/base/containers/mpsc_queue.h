@@ -0,0 +1,176 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// MPSCQueue is a lock-free, unbounded, multi-producer single-consumer queue.
+//
+// Any number of threads may call Push() concurrently. A single consumer thread
+// drains the queue with PopAll(), which hands back every element pushed so far
+// in the order in which the pushes took effect. Elements pushed from the same
+// thread are always delivered in the order in which that thread pushed them.
+//
+// Internally the queue is an intrusive singly-linked stack: Push() links a
+// node onto the head with a compare-and-swap, and PopAll() detaches the whole
+// list with one atomic exchange and reverses it. Nodes are recycled through a
+// bounded lock-free free list so that steady-state pushing does not touch the
+// heap for the queue bookkeeping.
+
+#ifndef BASE_CONTAINERS_MPSC_QUEUE_H_
+#define BASE_CONTAINERS_MPSC_QUEUE_H_
+
+#include "base/atomicops.h"
+#include "base/basictypes.h"
+#include "base/containers/lock_free_pointer_ring.h"
+#include "base/memory/manual_constructor.h"
+
+namespace base {
+
+// PushByTransfer() hands elements over to the queue through Store(), and
+// PopAll() hands them over to the consumer's container through Transfer().
+// The defaults copy the element; types that can be handed over more cheaply
+// (e.g. by swapping) can supply their own traits.
+template <class T>
+struct DefaultMPSCQueueTraits {
+  // |slot| is a default-constructed element inside the queue.
+  static void Store(T* value, T* slot) {
+    *slot = *value;
+  }
+
+  template <class Container>
+  static void Transfer(T* value, Container* out) {
+    out->push(*value);
+  }
+};
+
+template <class T, class Traits = DefaultMPSCQueueTraits<T> >
+class MPSCQueue {
+ public:
+  // The default number of nodes kept around for reuse once they have been
+  // drained by the consumer.
+  static const size_t kDefaultMaxFreeNodes = 256;
+
+  // |max_free_nodes| is rounded up to a power of two.
+  explicit MPSCQueue(size_t max_free_nodes)
+      : head_(0),
+        free_nodes_(max_free_nodes) {
+  }
+
+  MPSCQueue()
+      : head_(0),
+        free_nodes_(kDefaultMaxFreeNodes) {
+  }
+
+  // Must only be called once no producer can push anymore. Elements that were
+  // never popped are destroyed.
+  ~MPSCQueue() {
+    Node* node = reinterpret_cast<Node*>(subtle::NoBarrier_Load(&head_));
+    while (node) {
+      Node* next = node->next;
+      node->value.Destroy();
+      delete node;
+      node = next;
+    }
+    while ((node = free_nodes_.Pop()) != NULL)
+      delete node;
+  }
+
+  // Appends a copy of |value|. May be called from any thread. Returns true if
+  // the queue was empty immediately before |value| was added; the caller can
+  // use this to decide whether the consumer needs to be woken up.
+  bool Push(const T& value) {
+    Node* node = NewNode();
+    node->value.Init(value);
+    return Link(node);
+  }
+
+  // Same as Push() but hands |*value| over through Traits::Store() instead of
+  // copying it. T must be default-constructible. What is left in |*value|
+  // depends on the traits.
+  bool PushByTransfer(T* value) {
+    Node* node = NewNode();
+    node->value.Init();
+    Traits::Store(value, node->value.get());
+    return Link(node);
+  }
+
+  // Moves every queued element into |out| (anything Traits::Transfer()
+  // supports, e.g. std::queue for the default traits) in FIFO order. Must only
+  // be called from the consumer thread. Returns the number of elements moved.
+  template <class Container>
+  size_t PopAll(Container* out) {
+    Node* node = reinterpret_cast<Node*>(
+        subtle::NoBarrier_AtomicExchange(&head_, 0));
+    if (!node)
+      return 0;
+    subtle::MemoryBarrier();
+
+    // The detached list is in LIFO order; reverse it.
+    Node* reversed = NULL;
+    while (node) {
+      Node* next = node->next;
+      node->next = reversed;
+      reversed = node;
+      node = next;
+    }
+
+    size_t count = 0;
+    while (reversed) {
+      Node* next = reversed->next;
+      Traits::Transfer(reversed->value.get(), out);
+      // Destroy the element right away so that nothing it references outlives
+      // the hand-off to |out|.
+      reversed->value.Destroy();
+      if (!free_nodes_.Push(reversed))
+        delete reversed;
+      reversed = next;
+      ++count;
+    }
+    return count;
+  }
+
+  // Returns true if nothing is queued. The result is only a snapshot when
+  // producers are active.
+  bool IsEmpty() const {
+    return subtle::Acquire_Load(&head_) == 0;
+  }
+
+ private:
+  struct Node {
+    Node* next;
+    ManualConstructor<T> value;
+  };
+
+  Node* NewNode() {
+    Node* node = free_nodes_.Pop();
+    return node ? node : new Node;
+  }
+
+  // Links |node|, whose value is already constructed, onto the head. Returns
+  // true if the queue was empty before.
+  bool Link(Node* node) {
+    subtle::AtomicWord old_head = subtle::NoBarrier_Load(&head_);
+    for (;;) {
+      node->next = reinterpret_cast<Node*>(old_head);
+      // The release barrier publishes |node->value| and |node->next| to the
+      // consumer. Pushing never dereferences the old head, so a recycled node
+      // reappearing at the head (ABA) is harmless here.
+      subtle::AtomicWord previous = subtle::Release_CompareAndSwap(
+          &head_, old_head, reinterpret_cast<subtle::AtomicWord>(node));
+      if (previous == old_head)
+        break;
+      old_head = previous;
+    }
+    return old_head == 0;
+  }
+
+  // Points to the most recently pushed Node, or 0 if the queue is empty.
+  volatile subtle::AtomicWord head_;
+
+  LockFreePointerRing<Node> free_nodes_;
+
+  DISALLOW_COPY_AND_ASSIGN(MPSCQueue);
+};
+
+}  // namespace base
+
+#endif  // BASE_CONTAINERS_MPSC_QUEUE_H_
@@ -0,0 +1,195 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/containers/mpsc_queue.h"
+
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/memory/scoped_vector.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace {
+
+struct Item {
+  Item(int producer, int value) : producer(producer), value(value) {}
+
+  int producer;
+  int value;
+};
+
+// Counts live instances so that tests can check that the queue does not keep
+// elements alive after handing them out.
+class Counted {
+ public:
+  Counted() { ++live_; }
+  Counted(const Counted& other) { ++live_; }
+  ~Counted() { --live_; }
+
+  static int live() { return live_; }
+
+ private:
+  static int live_;
+};
+
+int Counted::live_ = 0;
+
+class Producer : public DelegateSimpleThread::Delegate {
+ public:
+  Producer(MPSCQueue<Item>* queue, int id, int count)
+      : queue_(queue), id_(id), count_(count) {}
+
+  virtual void Run() OVERRIDE {
+    for (int i = 0; i < count_; ++i)
+      queue_->Push(Item(id_, i));
+  }
+
+ private:
+  MPSCQueue<Item>* queue_;
+  int id_;
+  int count_;
+};
+
+TEST(MPSCQueueTest, Empty) {
+  MPSCQueue<int> queue;
+  EXPECT_TRUE(queue.IsEmpty());
+
+  std::queue<int> out;
+  EXPECT_EQ(0u, queue.PopAll(&out));
+  EXPECT_TRUE(out.empty());
+}
+
+TEST(MPSCQueueTest, FIFOOrder) {
+  MPSCQueue<int> queue;
+  EXPECT_TRUE(queue.Push(1));
+  EXPECT_FALSE(queue.Push(2));
+  EXPECT_FALSE(queue.Push(3));
+  EXPECT_FALSE(queue.IsEmpty());
+
+  std::queue<int> out;
+  EXPECT_EQ(3u, queue.PopAll(&out));
+  EXPECT_TRUE(queue.IsEmpty());
+  ASSERT_EQ(3u, out.size());
+  EXPECT_EQ(1, out.front()); out.pop();
+  EXPECT_EQ(2, out.front()); out.pop();
+  EXPECT_EQ(3, out.front()); out.pop();
+
+  // The queue reports empty again once drained.
+  EXPECT_TRUE(queue.Push(4));
+}
+
+TEST(MPSCQueueTest, RecyclesMoreNodesThanFreeListHolds) {
+  // A free list of two nodes must not lose or duplicate elements when more
+  // nodes than that are in flight.
+  MPSCQueue<int> queue(2);
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 10; ++i)
+      queue.Push(i);
+    std::queue<int> out;
+    EXPECT_EQ(10u, queue.PopAll(&out));
+    for (int i = 0; i < 10; ++i) {
+      EXPECT_EQ(i, out.front());
+      out.pop();
+    }
+  }
+}
+
+TEST(MPSCQueueTest, ReleasesElements) {
+  {
+    MPSCQueue<Counted> queue;
+    queue.Push(Counted());
+    queue.Push(Counted());
+    EXPECT_EQ(2, Counted::live());
+
+    std::queue<Counted> out;
+    queue.PopAll(&out);
+    // Only the copies handed out are alive; recycled nodes hold nothing.
+    EXPECT_EQ(2, Counted::live());
+    out.pop();
+    out.pop();
+    EXPECT_EQ(0, Counted::live());
+
+    // Elements still queued at destruction are destroyed with the queue.
+    queue.Push(Counted());
+  }
+  EXPECT_EQ(0, Counted::live());
+}
+
+// Hands strings in and out of the queue without copying their contents.
+struct StringSwapTraits {
+  static void Store(std::string* value, std::string* slot) {
+    slot->swap(*value);
+  }
+
+  static void Transfer(std::string* value, std::vector<std::string>* out) {
+    out->push_back(std::string());
+    out->back().swap(*value);
+  }
+};
+
+TEST(MPSCQueueTest, PushByTransfer) {
+  MPSCQueue<std::string, StringSwapTraits> queue;
+  std::string first("first");
+  std::string second("second");
+  EXPECT_TRUE(queue.PushByTransfer(&first));
+  EXPECT_FALSE(queue.PushByTransfer(&second));
+  EXPECT_TRUE(first.empty());
+  EXPECT_TRUE(second.empty());
+
+  std::vector<std::string> out;
+  EXPECT_EQ(2u, queue.PopAll(&out));
+  ASSERT_EQ(2u, out.size());
+  EXPECT_EQ("first", out[0]);
+  EXPECT_EQ("second", out[1]);
+
+  // The default traits copy.
+  MPSCQueue<int> ints;
+  int value = 7;
+  ints.PushByTransfer(&value);
+  EXPECT_EQ(7, value);
+  std::queue<int> int_out;
+  ints.PopAll(&int_out);
+  EXPECT_EQ(7, int_out.front());
+}
+
+TEST(MPSCQueueTest, ConcurrentProducers) {
+  const int kProducers = 4;
+  const int kItemsPerProducer = 10000;
+
+  MPSCQueue<Item> queue(16);
+  ScopedVector<Producer> producers;
+  ScopedVector<DelegateSimpleThread> threads;
+  for (int i = 0; i < kProducers; ++i) {
+    producers.push_back(new Producer(&queue, i, kItemsPerProducer));
+    threads.push_back(new DelegateSimpleThread(producers[i], "producer"));
+    threads[i]->Start();
+  }
+
+  // Drain concurrently with the producers; every producer's items must come
+  // out in the order they were pushed.
+  std::vector<int> next(kProducers, 0);
+  int total = 0;
+  while (total < kProducers * kItemsPerProducer) {
+    std::queue<Item> out;
+    queue.PopAll(&out);
+    while (!out.empty()) {
+      const Item& item = out.front();
+      ASSERT_EQ(next[item.producer], item.value);
+      ++next[item.producer];
+      ++total;
+      out.pop();
+    }
+  }
+
+  for (int i = 0; i < kProducers; ++i)
+    threads[i]->Join();
+  EXPECT_TRUE(queue.IsEmpty());
+}
+
+}  // namespace
+}  // namespace base
@@ -0,0 +1,333 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_compact_parser.h"
+
+#include <new>
+
+#include "base/compact_value.h"
+#include "base/float_util.h"
+#include "base/json/json_parser.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/values.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+bool IsNumberStart(char c) {
+  return c == '-' || (c >= '0' && c <= '9');
+}
+
+// Reads a run of digits starting at |*pos|. Mirrors JSONParser::ReadInt().
+bool ReadDigits(const StringPiece& text,
+                size_t* pos,
+                bool allow_leading_zeros) {
+  size_t start = *pos;
+  while (*pos < text.size() && text[*pos] >= '0' && text[*pos] <= '9')
+    ++*pos;
+  size_t length = *pos - start;
+  if (length == 0)
+    return false;
+  return allow_leading_zeros || length == 1 || text[start] != '0';
+}
+
+// Checks |text| against the number grammar of JSONParser::ConsumeNumber().
+bool IsValidNumber(const StringPiece& text) {
+  size_t pos = 0;
+  if (pos < text.size() && text[pos] == '-')
+    ++pos;
+  if (!ReadDigits(text, &pos, false))
+    return false;
+  if (pos < text.size() && text[pos] == '.') {
+    ++pos;
+    if (!ReadDigits(text, &pos, true))
+      return false;
+  }
+  if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+    ++pos;
+    if (pos < text.size() && (text[pos] == '-' || text[pos] == '+'))
+      ++pos;
+    if (!ReadDigits(text, &pos, true))
+      return false;
+  }
+  return pos == text.size();
+}
+
+}  // namespace
+
+JSONCompactParser::JSONCompactParser(int options)
+    : options_(options),
+      arena_(NULL),
+      error_code_(JSONReader::JSON_NO_ERROR) {
+}
+
+JSONCompactParser::~JSONCompactParser() {
+}
+
+CompactValue* JSONCompactParser::Parse(const StringPiece& input,
+                                       CompactValueArena* arena) {
+  input_ = input;
+  arena_ = arena;
+  error_code_ = JSONReader::JSON_NO_ERROR;
+
+  // Skip a UTF-8 byte order mark, like JSONParser does.
+  if (input_.starts_with("\xEF\xBB\xBF"))
+    input_.remove_prefix(3);
+
+  CompactValue* root = ParseDocument();
+  if (!root)
+    ReportFirstError(input);
+  return root;
+}
+
+CompactValue* JSONCompactParser::ParseDocument() {
+  if (!index_.Build(input_)) {
+    error_code_ = index_.error_code();
+    return NULL;
+  }
+  if (index_.size() == 0) {
+    error_code_ = JSONReader::JSON_UNEXPECTED_TOKEN;
+    return NULL;
+  }
+
+  CompactValue* root = new (arena_->Allocate(sizeof(CompactValue)))
+      CompactValue;
+  size_t next = 0;
+  if (!ParseElement(0, root, &next))
+    return NULL;
+  if (next != index_.size()) {
+    // JSONParser checks the token following a number as part of the number.
+    error_code_ = IsNumberStart(TokenChar(0)) ?
+        JSONReader::JSON_SYNTAX_ERROR :
+        JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT;
+    return NULL;
+  }
+  return root;
+}
+
+void JSONCompactParser::ReportFirstError(const StringPiece& input) {
+  // The structural index checks strings and brackets across the whole input
+  // before any element is parsed, so the error found above is not always the
+  // first one. JSONParser stops at the first error; errors are rare enough to
+  // simply ask it. It accepts comments and fails without a code for numbers
+  // out of the range of a double, so keep our own code in those cases.
+  JSONParser parser(options_);
+  scoped_ptr<Value> value(parser.Parse(input));
+  if (!value && parser.error_code() != JSONReader::JSON_NO_ERROR)
+    error_code_ = parser.error_code();
+}
+
+bool JSONCompactParser::ParseElement(size_t token,
+                                     CompactValue* out,
+                                     size_t* next) {
+  switch (TokenChar(token)) {
+    case '[':
+      if (!ParseList(token, out))
+        return false;
+      *next = index_.match(token) + 1;
+      return true;
+    case '{':
+      if (!ParseDictionary(token, out))
+        return false;
+      *next = index_.match(token) + 1;
+      return true;
+    case '"': {
+      StringPiece str;
+      if (!DecodeString(token, &str))
+        return false;
+      out->SetString(str, arena_);
+      *next = token + 1;
+      return true;
+    }
+    case '}':
+    case ']':
+    case ',':
+    case ':':
+    case '\0':
+      error_code_ = JSONReader::JSON_UNEXPECTED_TOKEN;
+      return false;
+    default:
+      if (!ParseScalar(token, out))
+        return false;
+      *next = token + 1;
+      return true;
+  }
+}
+
+bool JSONCompactParser::ParseList(size_t token, CompactValue* out) {
+  size_t end = index_.match(token);
+  size_t count = CountElements(token);
+  CompactValue* items = out->SetList(count, arena_);
+  size_t next = token + 1;
+  for (size_t i = 0; i < count; ++i) {
+    if (!ParseElement(next, &items[i], &next) ||
+        !ConsumeSeparator(&next, i + 1 == count, end)) {
+      return false;
+    }
+  }
+  return next == end;
+}
+
+bool JSONCompactParser::ParseDictionary(size_t token, CompactValue* out) {
+  size_t end = index_.match(token);
+  size_t count = CountElements(token);
+  CompactValue::Entry* entries = out->SetDictionary(count, arena_);
+  size_t next = token + 1;
+  for (size_t i = 0; i < count; ++i) {
+    if (TokenChar(next) != '"') {
+      error_code_ = JSONReader::JSON_UNQUOTED_DICTIONARY_KEY;
+      return false;
+    }
+    StringPiece key;
+    if (!DecodeString(next, &key))
+      return false;
+    entries[i].SetKey(key, arena_);
+    if (TokenChar(next + 1) != ':') {
+      error_code_ = JSONReader::JSON_SYNTAX_ERROR;
+      return false;
+    }
+    next += 2;
+    if (!ParseElement(next, &entries[i].value, &next) ||
+        !ConsumeSeparator(&next, i + 1 == count, end)) {
+      return false;
+    }
+  }
+  out->FinishDictionary();
+  return next == end;
+}
+
+bool JSONCompactParser::ParseScalar(size_t token, CompactValue* out) {
+  size_t begin = index_.offset(token);
+  StringPiece text = input_.substr(begin, ScalarEnd(input_, begin) - begin);
+
+  const char* literal = NULL;
+  switch (text[0]) {
+    case 't':
+      literal = "true";
+      if (text != literal)
+        break;
+      out->SetBoolean(true);
+      return true;
+    case 'f':
+      literal = "false";
+      if (text != literal)
+        break;
+      out->SetBoolean(false);
+      return true;
+    case 'n':
+      literal = "null";
+      if (text != literal)
+        break;
+      out->SetNull();
+      return true;
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9': {
+      if (!IsValidNumber(text))
+        break;
+      int num_int;
+      if (StringToInt(text, &num_int)) {
+        out->SetInteger(num_int);
+        return true;
+      }
+      double num_double;
+      if (StringToDouble(text.as_string(), &num_double) &&
+          IsFinite(num_double)) {
+        out->SetDouble(num_double);
+        return true;
+      }
+      // JSONParser fails without setting an error code here.
+      break;
+    }
+    default:
+      error_code_ = JSONReader::JSON_UNEXPECTED_TOKEN;
+      return false;
+  }
+  // JSONParser consumes a literal without looking at what follows, which at
+  // the root is then reported as data after the root.
+  if (token == 0 && literal && text.starts_with(literal)) {
+    error_code_ = JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT;
+    return false;
+  }
+  error_code_ = JSONReader::JSON_SYNTAX_ERROR;
+  return false;
+}
+
+bool JSONCompactParser::DecodeString(size_t token, StringPiece* out) {
+  size_t begin = index_.offset(token);
+  size_t end = ScalarEnd(input_, begin);
+  const char* content = input_.data() + begin + 1;
+  size_t length = end - begin - 2;
+  if (CountPlainStringBytes(content, content + length) == length) {
+    out->set(content, length);
+    return true;
+  }
+
+  // Escapes and multi-byte characters go through the full parser so that
+  // they are validated and decoded exactly like JSONReader does.
+  JSONParser parser(JSON_PARSE_RFC);
+  scoped_ptr<Value> value(parser.Parse(input_.substr(begin, end - begin)));
+  if (!value || !value->GetAsString(&scratch_)) {
+    error_code_ = parser.error_code();
+    return false;
+  }
+  out->set(scratch_.data(), scratch_.size());
+  return true;
+}
+
+size_t JSONCompactParser::CountElements(size_t token) const {
+  size_t end = index_.match(token);
+  if (token + 1 == end)
+    return 0;
+  size_t count = 1;
+  for (size_t i = token + 1; i < end; ++i) {
+    uint32 match = index_.match(i);
+    if (match != JSONStructuralIndex::kNoMatch)
+      i = match;
+    else if (TokenChar(i) == ',')
+      ++count;
+  }
+  // A trailing comma is not followed by an element.
+  if (TokenChar(end - 1) == ',' && end - 1 > token + 1)
+    --count;
+  return count;
+}
+
+bool JSONCompactParser::ConsumeSeparator(size_t* token, bool last, size_t end) {
+  if (!last) {
+    if (TokenChar(*token) != ',') {
+      error_code_ = JSONReader::JSON_SYNTAX_ERROR;
+      return false;
+    }
+    ++*token;
+    return true;
+  }
+  if (*token == end)
+    return true;
+  if (TokenChar(*token) == ',' && *token + 1 == end) {
+    if (!(options_ & JSON_ALLOW_TRAILING_COMMAS)) {
+      error_code_ = JSONReader::JSON_TRAILING_COMMA;
+      return false;
+    }
+    ++*token;
+    return true;
+  }
+  error_code_ = JSONReader::JSON_SYNTAX_ERROR;
+  return false;
+}
+
+}  // namespace internal
+}  // namespace base
@@ -0,0 +1,87 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_JSON_JSON_COMPACT_PARSER_H_
+#define BASE_JSON_JSON_COMPACT_PARSER_H_
+
+#include <string>
+
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_structural_index.h"
+#include "base/strings/string_piece.h"
+
+namespace base {
+
+class CompactValue;
+class CompactValueArena;
+
+namespace internal {
+
+// The implementation behind JSONReader::ReadCompact(). It builds a
+// CompactValue tree straight from a JSONStructuralIndex, without creating
+// base::Values, and validates the whole document. Scalars are decoded with
+// the same rules as JSONParser and errors are reported with the same codes;
+// see JSONReader::ReadCompact() for the exceptions. Comments are not
+// supported.
+class BASE_EXPORT_PRIVATE JSONCompactParser {
+ public:
+  explicit JSONCompactParser(int options);
+  ~JSONCompactParser();
+
+  // Parses |input| into |arena|. Returns NULL on error. The result does not
+  // refer to |input|.
+  CompactValue* Parse(const StringPiece& input, CompactValueArena* arena);
+
+  JSONReader::JsonParseError error_code() const { return error_code_; }
+
+ private:
+  // Indexes and parses |input_|. Returns NULL on error.
+  CompactValue* ParseDocument();
+
+  // Replaces |error_code_| with the code of the first error in |input|, as
+  // JSONParser reports it.
+  void ReportFirstError(const StringPiece& input);
+
+  // Fills |out| with the element starting at token |token|. On success,
+  // stores the token following the element in |next|.
+  bool ParseElement(size_t token, CompactValue* out, size_t* next);
+
+  bool ParseList(size_t token, CompactValue* out);
+  bool ParseDictionary(size_t token, CompactValue* out);
+  bool ParseScalar(size_t token, CompactValue* out);
+
+  // Decodes the string at |token|. |out| may point into the input or into
+  // |scratch_|, so it is only valid until the next call.
+  bool DecodeString(size_t token, StringPiece* out);
+
+  // Returns the number of elements in the container starting at |token|.
+  // Nested containers are skipped using the bracket matches.
+  size_t CountElements(size_t token) const;
+
+  // Checks the token at |*token|, which follows an element of the container
+  // ending at token |end|. If |last| is false, it must be a comma and
+  // |*token| is advanced past it. Otherwise it must be the closing bracket,
+  // optionally preceded by a trailing comma.
+  bool ConsumeSeparator(size_t* token, bool last, size_t end);
+
+  char TokenChar(size_t token) const {
+    return token < index_.size() ? input_[index_.offset(token)] : '\0';
+  }
+
+  const int options_;
+  StringPiece input_;
+  JSONStructuralIndex index_;
+  CompactValueArena* arena_;
+  std::string scratch_;
+  JSONReader::JsonParseError error_code_;
+
+  DISALLOW_COPY_AND_ASSIGN(JSONCompactParser);
+};
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_COMPACT_PARSER_H_
@@ -0,0 +1,188 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_compact_parser.h"
+
+#include "base/compact_value.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+// Inputs that JSONReader accepts. ReadCompact() must produce the same values.
+const char* const kValidInputs[] = {
+  "{}",
+  "[]",
+  "  [ ]  ",
+  "null",
+  "true",
+  "-0",
+  "42",
+  "-2147483648",
+  "2147483648",
+  "1.5e300",
+  "0.000001",
+  "1E+2",
+  "\"\"",
+  "\"plain ascii string\"",
+  "\"escapes \\\" \\\\ \\/ \\b \\f \\n \\r \\t \\v \\x41 \\u00e9\"",
+  "\"surrogates \\ud83d\\ude07\"",
+  "\"utf-8 \xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x87\"",
+  "\xEF\xBB\xBF{\"bom\": true}",
+  "{\"b\": 1, \"a\": 2, \"b\": 3}",
+  "{\"nested\": {\"list\": [1, [2, [3, {}]], {\"x\": \"}]\"}]}}",
+  "[1,2,3,\"a\",\"b\",null,true,false,[],{},-1.25]",
+  "{\"\\u0041\": \"key with escape\", \"A\": \"same key, plain\"}",
+  "{\"\": \"empty key\"}",
+  "[\"control\tcharacters\nare accepted\"]",
+};
+
+// Inputs that JSONReader rejects.
+const char* const kInvalidInputs[] = {
+  "",
+  "   ",
+  "[",
+  "]",
+  "{\"a\": 1",
+  "[1 2]",
+  "[1,,2]",
+  "[,]",
+  "[1,]",
+  "{\"a\": 1,}",
+  "{\"a\" 1}",
+  "{\"a\": }",
+  "{a: 1}",
+  "{1: 1}",
+  "[tru]",
+  "[nul]",
+  "[01]",
+  "[1.]",
+  "[.5]",
+  "[1e]",
+  "[--1]",
+  "[1.5e999]",
+  "[\"\\q\"]",
+  "[\"\\u12\"]",
+  "[\"\\ud800\"]",
+  "[\"bad \xff utf-8\"]",
+  "\"unterminated",
+  "[1] [2]",
+  "{} x",
+  "1 2",
+  "1 ]",
+  "nullx",
+  "truex",
+  "[1x]",
+  "{\"a\": 1}}",
+  "]",
+  "[1, 2}",
+  "[{]}",
+  "{\"a\": [}",
+  "{,}",
+  "{\"a\": 1,,}",
+  "{\"a\" 1}",
+  "{\"a\": 1 \"b\": 2}",
+  "[[] []]",
+  "[1:2]",
+  "x",
+  "1e999",
+};
+
+}  // namespace
+
+TEST(JSONCompactParserTest, MatchesJSONReader) {
+  for (size_t i = 0; i < arraysize(kValidInputs); ++i) {
+    scoped_ptr<Value> expected(JSONReader::Read(kValidInputs[i]));
+    ASSERT_TRUE(expected.get()) << kValidInputs[i];
+
+    CompactValueArena arena;
+    JSONCompactParser parser(JSON_PARSE_RFC);
+    CompactValue* compact = parser.Parse(kValidInputs[i], &arena);
+    ASSERT_TRUE(compact) << kValidInputs[i];
+    EXPECT_EQ(JSONReader::JSON_NO_ERROR, parser.error_code());
+    scoped_ptr<Value> actual(compact->ToValue());
+    EXPECT_TRUE(expected->Equals(actual.get())) << kValidInputs[i];
+
+    // The writer must produce identical output for both representations.
+    std::string expected_json;
+    std::string actual_json;
+    JSONWriter::Write(expected.get(), &expected_json);
+    JSONWriter::WriteCompact(*compact, 0, &actual_json);
+    EXPECT_EQ(expected_json, actual_json);
+    JSONWriter::WriteWithOptions(expected.get(),
+                                 JSONWriter::OPTIONS_PRETTY_PRINT,
+                                 &expected_json);
+    JSONWriter::WriteCompact(*compact, JSONWriter::OPTIONS_PRETTY_PRINT,
+                             &actual_json);
+    EXPECT_EQ(expected_json, actual_json);
+  }
+}
+
+// Errors are reported with the same codes as JSONReader.
+TEST(JSONCompactParserTest, RejectsWhatJSONReaderRejects) {
+  for (size_t i = 0; i < arraysize(kInvalidInputs); ++i) {
+    int expected_error = JSONReader::JSON_NO_ERROR;
+    std::string error_message;
+    scoped_ptr<Value> value(JSONReader::ReadAndReturnError(
+        kInvalidInputs[i], JSON_PARSE_RFC, &expected_error, &error_message));
+    EXPECT_FALSE(value.get()) << kInvalidInputs[i];
+
+    CompactValueArena arena;
+    JSONCompactParser parser(JSON_PARSE_RFC);
+    EXPECT_FALSE(parser.Parse(kInvalidInputs[i], &arena)) << kInvalidInputs[i];
+    // JSONReader fails out of range numbers without an error code.
+    if (expected_error == JSONReader::JSON_NO_ERROR)
+      expected_error = JSONReader::JSON_SYNTAX_ERROR;
+    EXPECT_EQ(expected_error, parser.error_code()) << kInvalidInputs[i];
+  }
+}
+
+TEST(JSONCompactParserTest, ErrorCodes) {
+  CompactValueArena arena;
+  int error_code = JSONReader::JSON_NO_ERROR;
+  EXPECT_FALSE(JSONReader::ReadCompact("[1,]", JSON_PARSE_RFC, &arena,
+                                       &error_code));
+  EXPECT_EQ(JSONReader::JSON_TRAILING_COMMA, error_code);
+  EXPECT_FALSE(JSONReader::ReadCompact("{a: 1}", JSON_PARSE_RFC, &arena,
+                                       &error_code));
+  EXPECT_EQ(JSONReader::JSON_UNQUOTED_DICTIONARY_KEY, error_code);
+  EXPECT_FALSE(JSONReader::ReadCompact("[1] 2", JSON_PARSE_RFC, &arena,
+                                       &error_code));
+  EXPECT_EQ(JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT, error_code);
+  EXPECT_FALSE(JSONReader::ReadCompact("[\"\\q\"]", JSON_PARSE_RFC, &arena,
+                                       &error_code));
+  EXPECT_EQ(JSONReader::JSON_INVALID_ESCAPE, error_code);
+  // Unlike JSONReader, comments are not supported.
+  EXPECT_FALSE(JSONReader::ReadCompact("[/* comment */ 1]", JSON_PARSE_RFC,
+                                       &arena, &error_code));
+  EXPECT_EQ(JSONReader::JSON_UNEXPECTED_TOKEN, error_code);
+  // 99 levels of nesting are allowed, like in JSONReader.
+  std::string deep = std::string(100, '[') + std::string(100, ']');
+  EXPECT_FALSE(JSONReader::ReadCompact(deep, JSON_PARSE_RFC, &arena,
+                                       &error_code));
+  EXPECT_EQ(JSONReader::JSON_TOO_MUCH_NESTING, error_code);
+  deep = std::string(99, '[') + std::string(99, ']');
+  EXPECT_TRUE(JSONReader::ReadCompact(deep, JSON_PARSE_RFC, &arena,
+                                      &error_code));
+}
+
+TEST(JSONCompactParserTest, TrailingCommas) {
+  CompactValueArena arena;
+  CompactValue* root = JSONReader::ReadCompact(
+      "{\"a\": [1, 2, ], \"b\": {\"c\": true, }, }",
+      JSON_ALLOW_TRAILING_COMMAS, &arena, NULL);
+  ASSERT_TRUE(root);
+  ASSERT_EQ(2u, root->size());
+  EXPECT_EQ(2u, root->FindKey("a")->size());
+  EXPECT_EQ(1u, root->FindKey("b")->size());
+}
+
+}  // namespace internal
+}  // namespace base
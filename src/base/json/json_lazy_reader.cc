@@ -0,0 +1,385 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_lazy_reader.h"
+
+#include "base/json/json_parser.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+
+namespace base {
+
+namespace {
+
+bool IsValueStart(char c) {
+  switch (c) {
+    case '\0':
+    case '}':
+    case ']':
+    case ':':
+    case ',':
+      return false;
+    default:
+      return true;
+  }
+}
+
+// Returns true if a token starting with |c| ends a value: a closing bracket,
+// or a string or scalar, which are single tokens.
+bool IsValueEnd(char c) {
+  switch (c) {
+    case '\0':
+    case '{':
+    case '[':
+    case ':':
+    case ',':
+      return false;
+    default:
+      return true;
+  }
+}
+
+// Decodes integers of up to nine digits without going through JSONParser. The
+// grammar matches JSONParser::ConsumeNumber(): an optional minus sign and no
+// leading zeros. Returns false for anything else, including numbers that are
+// valid but need the full parser.
+bool ParseSmallInteger(const StringPiece& text, int* out) {
+  size_t pos = 0;
+  bool negative = false;
+  if (pos < text.size() && text[pos] == '-') {
+    negative = true;
+    ++pos;
+  }
+  size_t digits = text.size() - pos;
+  if (digits == 0 || digits > 9 || (digits > 1 && text[pos] == '0'))
+    return false;
+  int value = 0;
+  for (; pos < text.size(); ++pos) {
+    char c = text[pos];
+    if (c < '0' || c > '9')
+      return false;
+    value = value * 10 + (c - '0');
+  }
+  *out = negative ? -value : value;
+  return true;
+}
+
+}  // namespace
+
+JSONLazyValue::Iterator::Iterator(const JSONLazyValue& container)
+    : document_(container.document_),
+      is_dictionary_(false),
+      at_end_(true),
+      end_token_(0),
+      key_token_(0) {
+  char c = container.first_char();
+  if (c != '{' && c != '[')
+    return;
+  is_dictionary_ = c == '{';
+  end_token_ = document_->index_.match(container.token_);
+  Seek(container.token_ + 1);
+}
+
+JSONLazyValue::Iterator::~Iterator() {
+}
+
+void JSONLazyValue::Iterator::Advance() {
+  DCHECK(!at_end_);
+  size_t next = value_.NextToken();
+  if (next < end_token_ && document_->TokenChar(next) == ',') {
+    Seek(next + 1);
+    // A comma directly before the closing bracket is only allowed with
+    // JSON_ALLOW_TRAILING_COMMAS, but either way there is nothing left.
+  } else {
+    at_end_ = true;
+  }
+}
+
+bool JSONLazyValue::Iterator::GetKey(std::string* key) const {
+  DCHECK(!at_end_);
+  DCHECK(is_dictionary_);
+  return document_->DecodeString(key_token_, key);
+}
+
+void JSONLazyValue::Iterator::Seek(size_t token) {
+  at_end_ = true;
+  if (token >= end_token_)
+    return;
+  if (is_dictionary_) {
+    if (token + 2 >= end_token_ ||
+        document_->TokenChar(token) != '"' ||
+        document_->TokenChar(token + 1) != ':') {
+      return;
+    }
+    key_token_ = token;
+    token += 2;
+  }
+  if (!IsValueStart(document_->TokenChar(token)))
+    return;
+  value_ = JSONLazyValue(document_, token);
+  at_end_ = false;
+}
+
+JSONLazyValue::JSONLazyValue() : document_(NULL), token_(0) {
+}
+
+JSONLazyValue::JSONLazyValue(const JSONLazyDocument* document, size_t token)
+    : document_(document), token_(token) {
+}
+
+Value::Type JSONLazyValue::GetType() const {
+  switch (first_char()) {
+    case '{':
+      return Value::TYPE_DICTIONARY;
+    case '[':
+      return Value::TYPE_LIST;
+    case '"':
+      return Value::TYPE_STRING;
+    case 't':
+    case 'f':
+      return Value::TYPE_BOOLEAN;
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9': {
+      int unused;
+      if (ParseSmallInteger(GetJSONText(), &unused))
+        return Value::TYPE_INTEGER;
+      scoped_ptr<Value> value(ToValue());
+      return value && value->IsType(Value::TYPE_INTEGER) ?
+          Value::TYPE_INTEGER : Value::TYPE_DOUBLE;
+    }
+    default:
+      return Value::TYPE_NULL;
+  }
+}
+
+bool JSONLazyValue::GetAsBoolean(bool* out_value) const {
+  if (!document_)
+    return false;
+  StringPiece text = GetJSONText();
+  if (text == "true") {
+    *out_value = true;
+    return true;
+  }
+  if (text == "false") {
+    *out_value = false;
+    return true;
+  }
+  return false;
+}
+
+bool JSONLazyValue::GetAsInteger(int* out_value) const {
+  if (!document_)
+    return false;
+  StringPiece text = GetJSONText();
+  if (ParseSmallInteger(text, out_value))
+    return true;
+  char c = first_char();
+  if (c != '-' && (c < '0' || c > '9'))
+    return false;
+  scoped_ptr<Value> value(document_->ParseRange(
+      document_->index_.offset(token_),
+      document_->index_.offset(token_) + text.size(),
+      JSON_PARSE_RFC));
+  return value && value->GetAsInteger(out_value);
+}
+
+bool JSONLazyValue::GetAsDouble(double* out_value) const {
+  if (!document_)
+    return false;
+  StringPiece text = GetJSONText();
+  int int_value;
+  if (ParseSmallInteger(text, &int_value)) {
+    *out_value = int_value;
+    return true;
+  }
+  char c = first_char();
+  if (c != '-' && (c < '0' || c > '9'))
+    return false;
+  scoped_ptr<Value> value(document_->ParseRange(
+      document_->index_.offset(token_),
+      document_->index_.offset(token_) + text.size(),
+      JSON_PARSE_RFC));
+  return value && value->GetAsDouble(out_value);
+}
+
+bool JSONLazyValue::GetAsString(std::string* out_value) const {
+  if (first_char() != '"')
+    return false;
+  return document_->DecodeString(token_, out_value);
+}
+
+bool JSONLazyValue::FindKey(const StringPiece& key,
+                            JSONLazyValue* out_value) const {
+  if (first_char() != '{')
+    return false;
+  bool found = false;
+  for (Iterator it(*this); !it.IsAtEnd(); it.Advance()) {
+    if (document_->StringEquals(it.key_token_, key)) {
+      *out_value = it.value();
+      found = true;
+    }
+  }
+  return found;
+}
+
+bool JSONLazyValue::GetBooleanForKey(const StringPiece& key,
+                                     bool* out_value) const {
+  JSONLazyValue value;
+  return FindKey(key, &value) && value.GetAsBoolean(out_value);
+}
+
+bool JSONLazyValue::GetIntegerForKey(const StringPiece& key,
+                                     int* out_value) const {
+  JSONLazyValue value;
+  return FindKey(key, &value) && value.GetAsInteger(out_value);
+}
+
+bool JSONLazyValue::GetStringForKey(const StringPiece& key,
+                                    std::string* out_value) const {
+  JSONLazyValue value;
+  return FindKey(key, &value) && value.GetAsString(out_value);
+}
+
+size_t JSONLazyValue::GetSize() const {
+  size_t size = 0;
+  for (Iterator it(*this); !it.IsAtEnd(); it.Advance())
+    ++size;
+  return size;
+}
+
+StringPiece JSONLazyValue::GetJSONText() const {
+  if (!document_)
+    return StringPiece();
+  const internal::JSONStructuralIndex& index = document_->index_;
+  size_t begin = index.offset(token_);
+  size_t end;
+  uint32 match = index.match(token_);
+  if (match != internal::JSONStructuralIndex::kNoMatch)
+    end = index.offset(match) + 1;
+  else
+    end = internal::ScalarEnd(document_->json_, begin);
+  return document_->json_.substr(begin, end - begin);
+}
+
+Value* JSONLazyValue::ToValue() const {
+  if (!document_)
+    return NULL;
+  StringPiece text = GetJSONText();
+  size_t begin = document_->index_.offset(token_);
+  return document_->ParseRange(begin, begin + text.size(),
+                               document_->options_);
+}
+
+char JSONLazyValue::first_char() const {
+  if (!document_)
+    return '\0';
+  return document_->TokenChar(token_);
+}
+
+size_t JSONLazyValue::NextToken() const {
+  uint32 match = document_->index_.match(token_);
+  if (match != internal::JSONStructuralIndex::kNoMatch)
+    return match + 1;
+  return token_ + 1;
+}
+
+JSONLazyDocument::JSONLazyDocument(int options)
+    : options_(options),
+      error_code_(JSONReader::JSON_NO_ERROR) {
+}
+
+JSONLazyDocument::JSONLazyDocument()
+    : options_(JSON_PARSE_RFC),
+      error_code_(JSONReader::JSON_NO_ERROR) {
+}
+
+JSONLazyDocument::~JSONLazyDocument() {
+}
+
+bool JSONLazyDocument::Parse(const StringPiece& json) {
+  json_ = json;
+  // Skip a UTF-8 byte order mark, like JSONParser does.
+  if (json_.starts_with("\xEF\xBB\xBF"))
+    json_.remove_prefix(3);
+
+  if (!index_.Build(json_)) {
+    error_code_ = index_.error_code();
+    return false;
+  }
+  if (index_.size() == 0 || !IsValueStart(TokenChar(0))) {
+    error_code_ = JSONReader::JSON_SYNTAX_ERROR;
+    return false;
+  }
+  if (JSONLazyValue(this, 0).NextToken() != index_.size()) {
+    error_code_ = JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT;
+    return false;
+  }
+  // Iteration relies on values being separated, so a missing comma must be
+  // caught here rather than silently ending a list or dictionary early.
+  for (size_t i = 1; i < index_.size(); ++i) {
+    if (IsValueEnd(TokenChar(i - 1)) && IsValueStart(TokenChar(i))) {
+      error_code_ = JSONReader::JSON_SYNTAX_ERROR;
+      return false;
+    }
+  }
+  error_code_ = JSONReader::JSON_NO_ERROR;
+  return true;
+}
+
+JSONLazyValue JSONLazyDocument::root() const {
+  DCHECK_EQ(JSONReader::JSON_NO_ERROR, error_code_);
+  DCHECK_GT(index_.size(), 0u);
+  return JSONLazyValue(this, 0);
+}
+
+char JSONLazyDocument::TokenChar(size_t token) const {
+  if (token >= index_.size())
+    return '\0';
+  return json_[index_.offset(token)];
+}
+
+bool JSONLazyDocument::DecodeString(size_t token, std::string* out) const {
+  size_t begin = index_.offset(token);
+  size_t end = internal::ScalarEnd(json_, begin);
+  const char* content = json_.data() + begin + 1;
+  size_t length = end - begin - 2;
+  if (internal::CountPlainStringBytes(content, content + length) == length) {
+    out->assign(content, length);
+    return true;
+  }
+  scoped_ptr<Value> value(ParseRange(begin, end, JSON_PARSE_RFC));
+  return value && value->GetAsString(out);
+}
+
+bool JSONLazyDocument::StringEquals(size_t token,
+                                    const StringPiece& key) const {
+  size_t begin = index_.offset(token);
+  size_t end = internal::ScalarEnd(json_, begin);
+  StringPiece content = json_.substr(begin + 1, end - begin - 2);
+  if (internal::CountPlainStringBytes(content.data(),
+                                      content.data() + content.size()) ==
+      content.size()) {
+    return content == key;
+  }
+  std::string decoded;
+  return DecodeString(token, &decoded) && decoded == key;
+}
+
+Value* JSONLazyDocument::ParseRange(size_t begin,
+                                    size_t end,
+                                    int options) const {
+  internal::JSONParser parser(options);
+  return parser.Parse(json_.substr(begin, end - begin));
+}
+
+}  // namespace base
@@ -0,0 +1,182 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// An on-demand JSON reader. Unlike JSONReader, which builds a complete tree of
+// base::Values, JSONLazyDocument only indexes the input (see
+// JSONStructuralIndex) and lets callers walk it through lightweight
+// JSONLazyValue handles. Nothing is decoded or allocated for the parts of the
+// document that are never looked at, which makes it a good fit for pulling a
+// few settings out of a large preferences or proxy configuration file.
+//
+// Usage:
+//   JSONLazyDocument document;
+//   if (!document.Parse(json))
+//     return false;
+//   JSONLazyValue proxy;
+//   std::string server;
+//   if (document.root().FindKey("proxy", &proxy) &&
+//       proxy.GetStringForKey("server", &server)) {
+//     ...
+//   }
+//
+// Scalars are decoded with the same rules as JSONReader, so every value read
+// through this API is identical to the one JSONReader would produce. However,
+// JSONLazyDocument::Parse() only checks that strings are terminated, that
+// brackets balance and that adjacent values are separated. Malformed scalars
+// are only reported, by the getters returning false, for the parts of the
+// document that are visited. Misplaced commas and colons are not always
+// reported: iteration, GetSize() and FindKey() stop at the first one.
+// Comments are not supported. Use JSONReader when the whole document must be
+// validated.
+
+#ifndef BASE_JSON_JSON_LAZY_READER_H_
+#define BASE_JSON_JSON_LAZY_READER_H_
+
+#include <string>
+
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_structural_index.h"
+#include "base/strings/string_piece.h"
+#include "base/values.h"
+
+namespace base {
+
+class JSONLazyDocument;
+
+// A handle to one element of a JSONLazyDocument. Handles are cheap to copy and
+// stay valid as long as the document (and the input it was parsed from) do.
+class BASE_EXPORT JSONLazyValue {
+ public:
+  class Iterator;
+
+  // Creates a handle to nothing; GetType() returns TYPE_NULL and every getter
+  // fails.
+  JSONLazyValue();
+
+  bool is_valid() const { return document_ != NULL; }
+
+  // Returns the type of the element. Numbers report TYPE_INTEGER if
+  // JSONReader would produce an integer for them, TYPE_DOUBLE otherwise.
+  Value::Type GetType() const;
+  bool IsType(Value::Type type) const { return GetType() == type; }
+
+  bool GetAsBoolean(bool* out_value) const;
+  bool GetAsInteger(int* out_value) const;
+  // Integers are converted, like Value::GetAsDouble() does.
+  bool GetAsDouble(double* out_value) const;
+  bool GetAsString(std::string* out_value) const;
+
+  // Looks up |key| in a dictionary without path expansion. If the key appears
+  // more than once, the last entry wins, as with JSONReader.
+  bool FindKey(const StringPiece& key, JSONLazyValue* out_value) const;
+
+  // Convenience wrappers around FindKey() and the getters above.
+  bool GetBooleanForKey(const StringPiece& key, bool* out_value) const;
+  bool GetIntegerForKey(const StringPiece& key, int* out_value) const;
+  bool GetStringForKey(const StringPiece& key, std::string* out_value) const;
+
+  // Returns the number of elements of a list or entries of a dictionary.
+  size_t GetSize() const;
+
+  // Returns the raw JSON text of the element.
+  StringPiece GetJSONText() const;
+
+  // Materializes the element and everything below it as a base::Value, using
+  // the document's JSONReader options. The caller owns the result, which is
+  // NULL if the element is malformed.
+  Value* ToValue() const;
+
+ private:
+  friend class JSONLazyDocument;
+
+  JSONLazyValue(const JSONLazyDocument* document, size_t token);
+
+  // Returns the first character of the element.
+  char first_char() const;
+
+  // Returns the index of the token following this element.
+  size_t NextToken() const;
+
+  const JSONLazyDocument* document_;
+  size_t token_;
+};
+
+// Iterates over the elements of a list or the entries of a dictionary. The
+// iterator is immediately at end for any other type or on a syntax error.
+class BASE_EXPORT JSONLazyValue::Iterator {
+ public:
+  explicit Iterator(const JSONLazyValue& container);
+  ~Iterator();
+
+  bool IsAtEnd() const { return at_end_; }
+  void Advance();
+
+  // Only valid for dictionaries. Decodes the key of the current entry.
+  bool GetKey(std::string* key) const;
+
+  const JSONLazyValue& value() const { return value_; }
+
+ private:
+  friend class JSONLazyValue;
+
+  // Positions on the element starting at token |token|, which must follow
+  // an opening bracket or a comma.
+  void Seek(size_t token);
+
+  const JSONLazyDocument* document_;
+  bool is_dictionary_;
+  bool at_end_;
+  // Token index of the container's closing bracket.
+  size_t end_token_;
+  size_t key_token_;
+  JSONLazyValue value_;
+
+  DISALLOW_COPY_AND_ASSIGN(Iterator);
+};
+
+class BASE_EXPORT JSONLazyDocument {
+ public:
+  // |options| are JSONReader options, used for ToValue().
+  explicit JSONLazyDocument(int options);
+  JSONLazyDocument();
+  ~JSONLazyDocument();
+
+  // Indexes |json|, which must outlive this document and all values obtained
+  // from it. Returns false on error; see error_code().
+  bool Parse(const StringPiece& json);
+
+  // The root element. Only valid after a successful Parse().
+  JSONLazyValue root() const;
+
+  JSONReader::JsonParseError error_code() const { return error_code_; }
+
+ private:
+  friend class JSONLazyValue;
+
+  // Returns the character at the start of token |token|, or '\0' if |token| is
+  // out of range.
+  char TokenChar(size_t token) const;
+
+  // Decodes the string token at |token|.
+  bool DecodeString(size_t token, std::string* out) const;
+
+  // Returns true if the string token at |token| equals |key| once decoded.
+  bool StringEquals(size_t token, const StringPiece& key) const;
+
+  // Parses [|begin|, |end|) of the input with JSONParser and |options|.
+  Value* ParseRange(size_t begin, size_t end, int options) const;
+
+  const int options_;
+  StringPiece json_;
+  internal::JSONStructuralIndex index_;
+  JSONReader::JsonParseError error_code_;
+
+  DISALLOW_COPY_AND_ASSIGN(JSONLazyDocument);
+};
+
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_LAZY_READER_H_
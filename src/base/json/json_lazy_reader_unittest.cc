@@ -0,0 +1,206 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_lazy_reader.h"
+
+#include "base/json/json_reader.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const char kDocument[] =
+    "{\n"
+    "  \"name\": \"lazy\",\n"
+    "  \"count\": 42,\n"
+    "  \"negative\": -7,\n"
+    "  \"big\": 12345678901,\n"
+    "  \"ratio\": 0.5,\n"
+    "  \"exp\": 1e2,\n"
+    "  \"enabled\": true,\n"
+    "  \"disabled\": false,\n"
+    "  \"nothing\": null,\n"
+    "  \"escaped\": \"tab\\there \\u00e9\",\n"
+    "  \"nested\": {\"list\": [1, [2, 3], {\"x\": \"}]\"}], \"y\": {}},\n"
+    "  \"name\": \"last wins\"\n"
+    "}\n";
+
+}  // namespace
+
+TEST(JSONLazyReaderTest, Scalars) {
+  JSONLazyDocument document;
+  ASSERT_TRUE(document.Parse(kDocument));
+  JSONLazyValue root = document.root();
+  EXPECT_EQ(Value::TYPE_DICTIONARY, root.GetType());
+
+  std::string str;
+  EXPECT_TRUE(root.GetStringForKey("name", &str));
+  EXPECT_EQ("last wins", str);
+  EXPECT_TRUE(root.GetStringForKey("escaped", &str));
+  EXPECT_EQ("tab\there \xc3\xa9", str);
+
+  int integer = 0;
+  EXPECT_TRUE(root.GetIntegerForKey("count", &integer));
+  EXPECT_EQ(42, integer);
+  EXPECT_TRUE(root.GetIntegerForKey("negative", &integer));
+  EXPECT_EQ(-7, integer);
+  EXPECT_FALSE(root.GetIntegerForKey("big", &integer));
+  EXPECT_FALSE(root.GetIntegerForKey("name", &integer));
+
+  JSONLazyValue value;
+  double number = 0;
+  ASSERT_TRUE(root.FindKey("big", &value));
+  EXPECT_EQ(Value::TYPE_DOUBLE, value.GetType());
+  EXPECT_TRUE(value.GetAsDouble(&number));
+  EXPECT_DOUBLE_EQ(12345678901.0, number);
+  ASSERT_TRUE(root.FindKey("ratio", &value));
+  EXPECT_EQ(Value::TYPE_DOUBLE, value.GetType());
+  EXPECT_TRUE(value.GetAsDouble(&number));
+  EXPECT_DOUBLE_EQ(0.5, number);
+  ASSERT_TRUE(root.FindKey("exp", &value));
+  EXPECT_EQ(Value::TYPE_DOUBLE, value.GetType());
+  ASSERT_TRUE(root.FindKey("count", &value));
+  EXPECT_EQ(Value::TYPE_INTEGER, value.GetType());
+  EXPECT_TRUE(value.GetAsDouble(&number));
+  EXPECT_DOUBLE_EQ(42.0, number);
+
+  bool boolean = false;
+  EXPECT_TRUE(root.GetBooleanForKey("enabled", &boolean));
+  EXPECT_TRUE(boolean);
+  EXPECT_TRUE(root.GetBooleanForKey("disabled", &boolean));
+  EXPECT_FALSE(boolean);
+
+  ASSERT_TRUE(root.FindKey("nothing", &value));
+  EXPECT_EQ(Value::TYPE_NULL, value.GetType());
+  EXPECT_FALSE(root.FindKey("missing", &value));
+}
+
+TEST(JSONLazyReaderTest, Containers) {
+  JSONLazyDocument document;
+  ASSERT_TRUE(document.Parse(kDocument));
+
+  JSONLazyValue nested;
+  ASSERT_TRUE(document.root().FindKey("nested", &nested));
+  EXPECT_EQ(2u, nested.GetSize());
+  EXPECT_EQ("{\"list\": [1, [2, 3], {\"x\": \"}]\"}], \"y\": {}}",
+            nested.GetJSONText().as_string());
+
+  JSONLazyValue list;
+  ASSERT_TRUE(nested.FindKey("list", &list));
+  EXPECT_EQ(Value::TYPE_LIST, list.GetType());
+  EXPECT_EQ(3u, list.GetSize());
+
+  JSONLazyValue::Iterator it(list);
+  ASSERT_FALSE(it.IsAtEnd());
+  EXPECT_EQ(Value::TYPE_INTEGER, it.value().GetType());
+  it.Advance();
+  ASSERT_FALSE(it.IsAtEnd());
+  EXPECT_EQ(2u, it.value().GetSize());
+  it.Advance();
+  ASSERT_FALSE(it.IsAtEnd());
+  std::string str;
+  EXPECT_TRUE(it.value().GetStringForKey("x", &str));
+  EXPECT_EQ("}]", str);
+  it.Advance();
+  EXPECT_TRUE(it.IsAtEnd());
+
+  JSONLazyValue empty;
+  ASSERT_TRUE(nested.FindKey("y", &empty));
+  EXPECT_EQ(0u, empty.GetSize());
+  EXPECT_TRUE(JSONLazyValue::Iterator(empty).IsAtEnd());
+
+  std::vector<std::string> keys;
+  for (JSONLazyValue::Iterator key_it(nested); !key_it.IsAtEnd();
+       key_it.Advance()) {
+    ASSERT_TRUE(key_it.GetKey(&str));
+    keys.push_back(str);
+  }
+  ASSERT_EQ(2u, keys.size());
+  EXPECT_EQ("list", keys[0]);
+  EXPECT_EQ("y", keys[1]);
+}
+
+// Everything read lazily must match what JSONReader produces.
+TEST(JSONLazyReaderTest, ToValueMatchesJSONReader) {
+  JSONLazyDocument document;
+  ASSERT_TRUE(document.Parse(kDocument));
+  scoped_ptr<Value> lazy(document.root().ToValue());
+  scoped_ptr<Value> eager(JSONReader::Read(kDocument));
+  ASSERT_TRUE(lazy.get());
+  ASSERT_TRUE(eager.get());
+  EXPECT_TRUE(lazy->Equals(eager.get()));
+
+  JSONLazyValue nested;
+  ASSERT_TRUE(document.root().FindKey("nested", &nested));
+  scoped_ptr<Value> nested_value(nested.ToValue());
+  DictionaryValue* eager_dict = NULL;
+  ASSERT_TRUE(eager->GetAsDictionary(&eager_dict));
+  const Value* eager_nested = NULL;
+  ASSERT_TRUE(eager_dict->GetWithoutPathExpansion("nested", &eager_nested));
+  EXPECT_TRUE(eager_nested->Equals(nested_value.get()));
+}
+
+TEST(JSONLazyReaderTest, ScalarRoot) {
+  JSONLazyDocument document;
+  ASSERT_TRUE(document.Parse("  \"just a string\"  "));
+  std::string str;
+  EXPECT_TRUE(document.root().GetAsString(&str));
+  EXPECT_EQ("just a string", str);
+
+  ASSERT_TRUE(document.Parse("\xEF\xBB\xBF" "17"));
+  int integer = 0;
+  EXPECT_TRUE(document.root().GetAsInteger(&integer));
+  EXPECT_EQ(17, integer);
+}
+
+TEST(JSONLazyReaderTest, Errors) {
+  JSONLazyDocument document;
+  EXPECT_FALSE(document.Parse(""));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, document.error_code());
+  EXPECT_FALSE(document.Parse("{\"a\": \"unterminated}"));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, document.error_code());
+  EXPECT_FALSE(document.Parse("[1, 2]]"));
+  EXPECT_EQ(JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT, document.error_code());
+  EXPECT_FALSE(document.Parse("[1, 2] 3"));
+  EXPECT_EQ(JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT, document.error_code());
+  // Missing commas are caught up front so that iteration can not silently
+  // stop early.
+  EXPECT_FALSE(document.Parse("[1 2, 3]"));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, document.error_code());
+  EXPECT_FALSE(document.Parse("{\"a\": 1 \"b\": 2}"));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, document.error_code());
+  EXPECT_FALSE(document.Parse("[[] {}]"));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, document.error_code());
+
+  // The nesting limit is the same as JSONReader's.
+  std::string deep = std::string(100, '[') + std::string(100, ']');
+  scoped_ptr<Value> value(JSONReader::Read(deep));
+  EXPECT_FALSE(value.get());
+  EXPECT_FALSE(document.Parse(deep));
+  EXPECT_EQ(JSONReader::JSON_TOO_MUCH_NESTING, document.error_code());
+  deep = std::string(99, '[') + std::string(99, ']');
+  value.reset(JSONReader::Read(deep));
+  EXPECT_TRUE(value.get());
+  EXPECT_TRUE(document.Parse(deep));
+
+  // Malformed scalars are only detected when they are read.
+  ASSERT_TRUE(document.Parse("{\"a\": tru, \"b\": 01, \"c\": \"\\q\"}"));
+  JSONLazyValue root = document.root();
+  bool boolean;
+  int integer;
+  std::string str;
+  EXPECT_FALSE(root.GetBooleanForKey("a", &boolean));
+  EXPECT_FALSE(root.GetIntegerForKey("b", &integer));
+  EXPECT_FALSE(root.GetStringForKey("c", &str));
+  EXPECT_FALSE(root.ToValue());
+
+  // Iteration stops at a trailing comma.
+  ASSERT_TRUE(document.Parse("[1, 2, ]"));
+  EXPECT_EQ(2u, document.root().GetSize());
+}
+
+}  // namespace base
@@ -5,6 +5,7 @@
 #include "base/json/json_parser.h"
 
 #include "base/float_util.h"
+#include "base/json/json_structural_index.h"
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/strings/string_number_conversions.h"
@@ -307,6 +308,14 @@ void JSONParser::StringBuilder::Append(const char& c) {
     ++length_;
 }
 
+void JSONParser::StringBuilder::AppendRun(const char* str, size_t length) {
+  DCHECK(string_ || str == pos_ + length_);
+  if (string_)
+    string_->append(str, length);
+  else
+    length_ += length;
+}
+
 void JSONParser::StringBuilder::AppendString(const std::string& str) {
   DCHECK(string_);
   string_->append(str);
@@ -615,6 +624,16 @@ bool JSONParser::ConsumeStringRaw(StringBuilder* out) {
   int32 next_char = 0;
 
   while (CanConsume(1)) {
+    // Copy runs of plain ASCII in bulk. Only quotes, escapes and multi-byte
+    // sequences need the character-at-a-time handling below.
+    size_t run = CountPlainStringBytes(start_pos_ + index_, end_pos_);
+    if (run > 0) {
+      string.AppendRun(start_pos_ + index_, run);
+      index_ += run;
+      pos_ = start_pos_ + index_ - 1;
+      continue;
+    }
+
     pos_ = start_pos_ + index_;  // CBU8_NEXT is postcrement.
     CBU8_NEXT(start_pos_, index_, length, next_char);
     if (next_char < 0 || !IsValidCharacter(next_char)) {
@@ -113,6 +113,11 @@ class BASE_EXPORT_PRIVATE JSONParser {
     // AppendString below.
     void Append(const char& c);
 
+    // Appends |length| bytes of basic ASCII starting at |str|. Unless the
+    // builder has been converted, |str| must directly follow the characters
+    // already in the builder.
+    void AppendRun(const char* str, size_t length);
+
     // Appends a string to the std::string. Must be Convert()ed to use.
     void AppendString(const std::string& str);
 
@@ -258,6 +263,7 @@ class BASE_EXPORT_PRIVATE JSONParser {
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeDictionary);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeList);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeString);
+  FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeLongStrings);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeLiterals);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeNumbers);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ErrorMessages);
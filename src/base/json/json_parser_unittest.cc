@@ -55,6 +55,31 @@ TEST_F(JSONParserTest, ConsumeString) {
   EXPECT_EQ("test", str);
 }
 
+// Long runs of plain ASCII are copied in bulk; make sure quotes, escapes and
+// multi-byte characters are still found at every position within a run.
+TEST_F(JSONParserTest, ConsumeLongStrings) {
+  const std::string kSpecials[] = {
+    "\\\"", "\\n", "\\u00e9", "\xc3\xa9", "\\\\"
+  };
+  const std::string kDecoded[] = { "\"", "\n", "\xc3\xa9", "\xc3\xa9", "\\" };
+  for (size_t special = 0; special < arraysize(kSpecials); ++special) {
+    for (size_t prefix = 0; prefix < 40; ++prefix) {
+      std::string plain(prefix, 'a');
+      std::string input = "\"" + plain + kSpecials[special] + plain + "\",|";
+      scoped_ptr<JSONParser> parser(NewTestParser(input));
+      scoped_ptr<Value> value(parser->ConsumeString());
+      EXPECT_EQ('"', *parser->pos_);
+
+      TestLastThree(parser.get());
+
+      ASSERT_TRUE(value.get());
+      std::string str;
+      EXPECT_TRUE(value->GetAsString(&str));
+      EXPECT_EQ(plain + kDecoded[special] + plain, str);
+    }
+  }
+}
+
 TEST_F(JSONParserTest, ConsumeList) {
   std::string input("[true, false],|");
   scoped_ptr<JSONParser> parser(NewTestParser(input));
@@ -0,0 +1,222 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/compact_value.h"
+#include "base/json/json_lazy_reader.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_structural_index.h"
+#include "base/json/json_writer.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/stringprintf.h"
+#include "base/test/perftimer.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+#if defined(OS_LINUX)
+#include <malloc.h>
+#endif
+
+namespace base {
+
+namespace {
+
+const int kRecords = 20000;
+const int kIterations = 10;
+
+// Builds a document of roughly 4 MB that looks like a preferences file: a
+// dictionary of records with strings of mixed length, numbers, booleans and
+// small nested lists.
+std::string MakeDocument() {
+  std::string json = "{\n";
+  for (int i = 0; i < kRecords; ++i) {
+    StringAppendF(&json,
+        "  \"record%d\": {\n"
+        "    \"id\": %d,\n"
+        "    \"name\": \"Record number %d\",\n"
+        "    \"url\": \"https://www.example.com/path/to/resource/%d?q=1\",\n"
+        "    \"description\": \"A longer string value that is typical of "
+        "titles and descriptions stored in JSON \\\"files\\\".\",\n"
+        "    \"score\": %d.%d,\n"
+        "    \"enabled\": %s,\n"
+        "    \"tags\": [\"alpha\", \"beta\", \"gamma\", %d, null]\n"
+        "  },\n",
+        i, i, i, i, i % 100, i % 7, i % 2 ? "true" : "false", i);
+  }
+  json += "  \"last\": \"value\"\n}\n";
+  return json;
+}
+
+double MegabytesPerSecond(size_t bytes, int iterations, TimeDelta elapsed) {
+  return bytes * static_cast<double>(iterations) /
+      (1024 * 1024) / elapsed.InSecondsF();
+}
+
+// Returns the number of heap bytes in use, or 0 if that is not known.
+size_t HeapBytesInUse() {
+#if defined(OS_LINUX)
+  struct mallinfo info = mallinfo();
+  return static_cast<size_t>(info.uordblks) +
+      static_cast<size_t>(info.hblkhd);
+#else
+  return 0;
+#endif
+}
+
+// Counts the scalars below |value| to make sure a walk touches everything.
+int WalkLazy(const JSONLazyValue& value) {
+  int count = 0;
+  for (JSONLazyValue::Iterator it(value); !it.IsAtEnd(); it.Advance()) {
+    switch (it.value().GetType()) {
+      case Value::TYPE_DICTIONARY:
+      case Value::TYPE_LIST:
+        count += WalkLazy(it.value());
+        break;
+      case Value::TYPE_STRING: {
+        std::string str;
+        if (it.value().GetAsString(&str))
+          ++count;
+        break;
+      }
+      default:
+        ++count;
+        break;
+    }
+  }
+  return count;
+}
+
+}  // namespace
+
+class JSONPerfTest : public testing::Test {
+ protected:
+  virtual void SetUp() OVERRIDE {
+    json_ = MakeDocument();
+  }
+
+  std::string json_;
+};
+
+TEST_F(JSONPerfTest, JSONReaderRead) {
+  PerfTimer timer;
+  for (int i = 0; i < kIterations; ++i) {
+    scoped_ptr<Value> root(JSONReader::Read(json_));
+    ASSERT_TRUE(root.get());
+  }
+  LogPerfResult("JSONReader_Read",
+                MegabytesPerSecond(json_.size(), kIterations, timer.Elapsed()),
+                "MB/s");
+}
+
+TEST_F(JSONPerfTest, ReadCompact) {
+  PerfTimer timer;
+  for (int i = 0; i < kIterations; ++i) {
+    CompactValueArena arena;
+    ASSERT_TRUE(JSONReader::ReadCompact(json_, JSON_PARSE_RFC, &arena, NULL));
+  }
+  LogPerfResult("JSONReader_ReadCompact",
+                MegabytesPerSecond(json_.size(), kIterations, timer.Elapsed()),
+                "MB/s");
+}
+
+TEST_F(JSONPerfTest, Write) {
+  scoped_ptr<Value> root(JSONReader::Read(json_));
+  ASSERT_TRUE(root.get());
+  std::string output;
+  PerfTimer timer;
+  for (int i = 0; i < kIterations; ++i)
+    JSONWriter::Write(root.get(), &output);
+  LogPerfResult("JSONWriter_Write",
+                MegabytesPerSecond(output.size(), kIterations, timer.Elapsed()),
+                "MB/s");
+}
+
+TEST_F(JSONPerfTest, WriteCompact) {
+  CompactValueArena arena;
+  CompactValue* root =
+      JSONReader::ReadCompact(json_, JSON_PARSE_RFC, &arena, NULL);
+  ASSERT_TRUE(root);
+  std::string output;
+  PerfTimer timer;
+  for (int i = 0; i < kIterations; ++i)
+    JSONWriter::WriteCompact(*root, 0, &output);
+  LogPerfResult("JSONWriter_WriteCompact",
+                MegabytesPerSecond(output.size(), kIterations, timer.Elapsed()),
+                "MB/s");
+}
+
+TEST_F(JSONPerfTest, ConvertCompact) {
+  scoped_ptr<Value> root(JSONReader::Read(json_));
+  ASSERT_TRUE(root.get());
+  PerfTimer timer;
+  for (int i = 0; i < kIterations; ++i) {
+    CompactValueArena arena;
+    CompactValue* compact = CompactValue::FromValue(*root, &arena);
+    scoped_ptr<Value> converted(compact->ToValue());
+  }
+  LogPerfResult("CompactValue_FromValueToValue",
+                MegabytesPerSecond(json_.size(), kIterations, timer.Elapsed()),
+                "MB/s");
+}
+
+// Memory held by the parsed document in each representation.
+TEST_F(JSONPerfTest, Memory) {
+  size_t before = HeapBytesInUse();
+  scoped_ptr<Value> root(JSONReader::Read(json_, JSON_DETACHABLE_CHILDREN));
+  ASSERT_TRUE(root.get());
+  size_t value_bytes = HeapBytesInUse() - before;
+
+  before = HeapBytesInUse();
+  CompactValueArena arena;
+  ASSERT_TRUE(JSONReader::ReadCompact(json_, JSON_PARSE_RFC, &arena, NULL));
+  size_t compact_heap_bytes = HeapBytesInUse() - before;
+
+  if (value_bytes) {
+    LogPerfResult("Value_Memory", value_bytes / 1024.0, "KB");
+    LogPerfResult("CompactValue_Memory", compact_heap_bytes / 1024.0, "KB");
+  }
+  LogPerfResult("CompactValue_ArenaReserved", arena.bytes_reserved() / 1024.0,
+                "KB");
+}
+
+TEST_F(JSONPerfTest, StructuralIndex) {
+  internal::JSONStructuralIndex index;
+  PerfTimer timer;
+  for (int i = 0; i < kIterations; ++i)
+    ASSERT_TRUE(index.Build(json_));
+  LogPerfResult("JSONStructuralIndex_Build",
+                MegabytesPerSecond(json_.size(), kIterations, timer.Elapsed()),
+                "MB/s");
+}
+
+// Parses the document and reads one value near the end, which is the common
+// case of extracting a setting from a large file.
+TEST_F(JSONPerfTest, LazyLookup) {
+  PerfTimer timer;
+  for (int i = 0; i < kIterations; ++i) {
+    JSONLazyDocument document;
+    ASSERT_TRUE(document.Parse(json_));
+    std::string value;
+    ASSERT_TRUE(document.root().GetStringForKey("last", &value));
+  }
+  LogPerfResult("JSONLazyDocument_Lookup",
+                MegabytesPerSecond(json_.size(), kIterations, timer.Elapsed()),
+                "MB/s");
+}
+
+TEST_F(JSONPerfTest, LazyWalk) {
+  PerfTimer timer;
+  for (int i = 0; i < kIterations; ++i) {
+    JSONLazyDocument document;
+    ASSERT_TRUE(document.Parse(json_));
+    EXPECT_EQ(kRecords * 11 + 1, WalkLazy(document.root()));
+  }
+  LogPerfResult("JSONLazyDocument_Walk",
+                MegabytesPerSecond(json_.size(), kIterations, timer.Elapsed()),
+                "MB/s");
+}
+
+}  // namespace base
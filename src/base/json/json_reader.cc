@@ -4,6 +4,7 @@
 
 #include "base/json/json_reader.h"
 
+#include "base/json/json_compact_parser.h"
 #include "base/json/json_parser.h"
 #include "base/logging.h"
 
@@ -68,6 +69,18 @@ Value* JSONReader::ReadAndReturnError(const StringPiece& json,
   return NULL;
 }
 
+// static
+CompactValue* JSONReader::ReadCompact(const StringPiece& json,
+                                      int options,
+                                      CompactValueArena* arena,
+                                      int* error_code_out) {
+  internal::JSONCompactParser parser(options);
+  CompactValue* root = parser.Parse(json, arena);
+  if (!root && error_code_out)
+    *error_code_out = parser.error_code();
+  return root;
+}
+
 // static
 std::string JSONReader::ErrorCodeToString(JsonParseError error_code) {
   switch (error_code) {
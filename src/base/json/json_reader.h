@@ -36,6 +36,8 @@
 #include "base/strings/string_piece.h"
 
 namespace base {
+class CompactValue;
+class CompactValueArena;
 class Value;
 
 namespace internal {
@@ -111,6 +113,21 @@ class BASE_EXPORT JSONReader {
                                    int* error_code_out,
                                    std::string* error_msg_out);
 
+  // Reads and parses |json| into a CompactValue allocated in |arena|, without
+  // creating base::Values. The whole input is validated and scalars are
+  // decoded exactly as Read() does, but comments are not supported and no
+  // error location is available. On failure the input is parsed again with
+  // Read()'s parser so that the error code is that of the first error, as
+  // Read() reports it. The exceptions are comments, which ReadCompact()
+  // rejects with its own code, and numbers out of the range of a double,
+  // which report JSON_SYNTAX_ERROR where Read() reports no code at all.
+  // |error_code_out| is optional. Returns NULL on error. JSON_DETACHABLE_CHILDREN has no
+  // effect.
+  static CompactValue* ReadCompact(const StringPiece& json,
+                                   int options,
+                                   CompactValueArena* arena,
+                                   int* error_code_out);
+
   // Converts a JSON parse error code into a human readable message.
   // Returns an empty string if error_code is JSON_NO_ERROR.
   static std::string ErrorCodeToString(JsonParseError error_code);
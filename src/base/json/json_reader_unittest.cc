@@ -5,6 +5,7 @@
 #include "base/json/json_reader.h"
 
 #include "base/base_paths.h"
+#include "base/compact_value.h"
 #include "base/file_util.h"
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
@@ -645,6 +646,57 @@ TEST(JSONReaderTest, InvalidSanity) {
   }
 }
 
+// ReadCompact() checks brackets across the whole input before it parses any
+// element, but must still report the first of several errors like Read().
+TEST(JSONReaderTest, CompactReportsFirstError) {
+  const char* const kInputs[] = {
+      "1[",
+      "\"\\q\"[",
+      "[1 2]]",
+      "{\"a\" 1}}",
+      "[\"\\q\", ]",
+      "[tru, [",
+      "{a: 1, \"b\"",
+      "[1,,]]]",
+      "[\"\\u12\"}",
+      "{\"a\": [1, }",
+  };
+  for (size_t i = 0; i < arraysize(kInputs); ++i) {
+    int read_error = JSONReader::JSON_NO_ERROR;
+    scoped_ptr<Value> value(JSONReader::ReadAndReturnError(
+        kInputs[i], JSON_PARSE_RFC, &read_error, NULL));
+    EXPECT_FALSE(value.get()) << kInputs[i];
+
+    CompactValueArena arena;
+    int compact_error = JSONReader::JSON_NO_ERROR;
+    EXPECT_FALSE(JSONReader::ReadCompact(kInputs[i], JSON_PARSE_RFC, &arena,
+                                         &compact_error));
+    EXPECT_EQ(read_error, compact_error) << kInputs[i];
+  }
+
+  // The same for a valid document with two bytes replaced.
+  const std::string kDocument =
+      "{\"a\": [1, 2.5, \"x\\ny\"], \"b\": {\"c\": null, \"d\": true}}";
+  const char kReplacements[] = "[]{}:,\"\\x1";
+  for (size_t i = 0; i < kDocument.size(); ++i) {
+    for (size_t j = i + 1; j < kDocument.size(); j += 3) {
+      std::string json = kDocument;
+      json[i] = kReplacements[i % (arraysize(kReplacements) - 1)];
+      json[j] = kReplacements[j % (arraysize(kReplacements) - 1)];
+      int read_error = JSONReader::JSON_NO_ERROR;
+      scoped_ptr<Value> value(JSONReader::ReadAndReturnError(
+          json, JSON_PARSE_RFC, &read_error, NULL));
+      CompactValueArena arena;
+      int compact_error = JSONReader::JSON_NO_ERROR;
+      bool compact_ok = JSONReader::ReadCompact(json, JSON_PARSE_RFC, &arena,
+                                                &compact_error) != NULL;
+      EXPECT_EQ(value.get() != NULL, compact_ok) << json;
+      if (!value && !compact_ok)
+        EXPECT_EQ(read_error, compact_error) << json;
+    }
+  }
+}
+
 TEST(JSONReaderTest, IllegalTrailingNull) {
   const char json[] = { '"', 'n', 'u', 'l', 'l', '"', '\0' };
   std::string json_string(json, sizeof(json));
@@ -0,0 +1,369 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_structural_index.h"
+
+#include <string.h>
+
+#include "base/logging.h"
+
+#if defined(ARCH_CPU_X86_FAMILY)
+#include <emmintrin.h>
+#endif
+
+#if defined(COMPILER_MSVC)
+#include <intrin.h>
+#endif
+
+namespace base {
+namespace internal {
+
+namespace {
+
+const size_t kBlockSize = 64;
+
+// Same limit as JSONParser, which rejects the 100th nested container.
+const size_t kMaxDepth = 100;
+
+bool IsScalarDelimiter(char c) {
+  switch (c) {
+    case '{':
+    case '}':
+    case '[':
+    case ']':
+    case ':':
+    case ',':
+    case '"':
+    case ' ':
+    case '\t':
+    case '\n':
+    case '\r':
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Bit masks describing one block of input; bit i stands for byte i.
+struct BlockMasks {
+  uint64 backslash;
+  uint64 quote;
+  uint64 structural;
+  uint64 whitespace;
+};
+
+inline int CountTrailingZeros(uint64 value) {
+  DCHECK(value);
+#if defined(COMPILER_MSVC)
+  unsigned long index;
+#if defined(ARCH_CPU_64_BITS)
+  _BitScanForward64(&index, value);
+  return static_cast<int>(index);
+#else
+  if (_BitScanForward(&index, static_cast<uint32>(value)))
+    return static_cast<int>(index);
+  _BitScanForward(&index, static_cast<uint32>(value >> 32));
+  return static_cast<int>(index) + 32;
+#endif
+#else
+  return __builtin_ctzll(value);
+#endif
+}
+
+// Returns a mask with bit i set if an odd number of bits at or below i are set
+// in |value|. Applied to the quote mask, this yields the bytes inside strings.
+inline uint64 PrefixXor(uint64 value) {
+  value ^= value << 1;
+  value ^= value << 2;
+  value ^= value << 4;
+  value ^= value << 8;
+  value ^= value << 16;
+  value ^= value << 32;
+  return value;
+}
+
+#if defined(ARCH_CPU_X86_FAMILY)
+
+inline uint64 MoveMask(__m128i bytes, int shift) {
+  return static_cast<uint64>(static_cast<uint32>(_mm_movemask_epi8(bytes)))
+      << shift;
+}
+
+// |block| must have kBlockSize readable bytes.
+void ClassifyBlock(const char* block, BlockMasks* masks) {
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i open_brace = _mm_set1_epi8('{');
+  const __m128i close_brace = _mm_set1_epi8('}');
+  const __m128i open_bracket = _mm_set1_epi8('[');
+  const __m128i close_bracket = _mm_set1_epi8(']');
+  const __m128i colon = _mm_set1_epi8(':');
+  const __m128i comma = _mm_set1_epi8(',');
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i line_feed = _mm_set1_epi8('\n');
+  const __m128i carriage_return = _mm_set1_epi8('\r');
+
+  masks->backslash = 0;
+  masks->quote = 0;
+  masks->structural = 0;
+  masks->whitespace = 0;
+  for (int i = 0; i < 4; ++i) {
+    __m128i bytes = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(block + i * 16));
+    masks->backslash |= MoveMask(_mm_cmpeq_epi8(bytes, backslash), i * 16);
+    masks->quote |= MoveMask(_mm_cmpeq_epi8(bytes, quote), i * 16);
+    __m128i structural = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, open_brace),
+                     _mm_cmpeq_epi8(bytes, close_brace)),
+        _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, open_bracket),
+                         _mm_cmpeq_epi8(bytes, close_bracket)),
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, colon),
+                         _mm_cmpeq_epi8(bytes, comma))));
+    masks->structural |= MoveMask(structural, i * 16);
+    __m128i whitespace = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, space),
+                     _mm_cmpeq_epi8(bytes, tab)),
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, line_feed),
+                     _mm_cmpeq_epi8(bytes, carriage_return)));
+    masks->whitespace |= MoveMask(whitespace, i * 16);
+  }
+}
+
+#else  // defined(ARCH_CPU_X86_FAMILY)
+
+void ClassifyBlock(const char* block, BlockMasks* masks) {
+  masks->backslash = 0;
+  masks->quote = 0;
+  masks->structural = 0;
+  masks->whitespace = 0;
+  for (size_t i = 0; i < kBlockSize; ++i) {
+    uint64 bit = static_cast<uint64>(1) << i;
+    switch (block[i]) {
+      case '\\':
+        masks->backslash |= bit;
+        break;
+      case '"':
+        masks->quote |= bit;
+        break;
+      case '{':
+      case '}':
+      case '[':
+      case ']':
+      case ':':
+      case ',':
+        masks->structural |= bit;
+        break;
+      case ' ':
+      case '\t':
+      case '\n':
+      case '\r':
+        masks->whitespace |= bit;
+        break;
+    }
+  }
+}
+
+#endif  // defined(ARCH_CPU_X86_FAMILY)
+
+}  // namespace
+
+// static
+const uint32 JSONStructuralIndex::kNoMatch;
+
+size_t CountPlainStringBytes(const char* begin, const char* end) {
+  const char* pos = begin;
+#if defined(ARCH_CPU_X86_FAMILY)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  while (end - pos >= 16) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+    // The sign bit of |bytes| itself flags non-ASCII bytes.
+    __m128i special = _mm_or_si128(
+        bytes, _mm_or_si128(_mm_cmpeq_epi8(bytes, quote),
+                            _mm_cmpeq_epi8(bytes, backslash)));
+    int mask = _mm_movemask_epi8(special);
+    if (mask)
+      return (pos - begin) + CountTrailingZeros(static_cast<uint64>(mask));
+    pos += 16;
+  }
+#endif
+  while (pos < end) {
+    unsigned char c = static_cast<unsigned char>(*pos);
+    if (c >= 0x80 || c == '"' || c == '\\')
+      break;
+    ++pos;
+  }
+  return pos - begin;
+}
+
+size_t FindStringEnd(const StringPiece& json, size_t offset) {
+  const char* data = json.data();
+  size_t size = json.size();
+  DCHECK_EQ('"', data[offset]);
+  size_t pos = offset + 1;
+  for (;;) {
+    pos += CountPlainStringBytes(data + pos, data + size);
+    DCHECK_LT(pos, size);
+    if (data[pos] == '"')
+      return pos + 1;
+    pos += data[pos] == '\\' ? 2 : 1;
+  }
+}
+
+size_t ScalarEnd(const StringPiece& json, size_t offset) {
+  if (json[offset] == '"')
+    return FindStringEnd(json, offset);
+  size_t pos = offset + 1;
+  while (pos < json.size() && !IsScalarDelimiter(json[pos]))
+    ++pos;
+  return pos;
+}
+
+JSONStructuralIndex::JSONStructuralIndex()
+    : in_string_(false),
+      escape_next_(false),
+      previous_was_scalar_(false),
+      error_code_(JSONReader::JSON_NO_ERROR) {
+}
+
+JSONStructuralIndex::~JSONStructuralIndex() {
+}
+
+bool JSONStructuralIndex::Build(const StringPiece& json) {
+  offsets_.clear();
+  matches_.clear();
+  in_string_ = false;
+  escape_next_ = false;
+  previous_was_scalar_ = false;
+  error_code_ = JSONReader::JSON_NO_ERROR;
+
+  if (json.size() >= kNoMatch) {
+    error_code_ = JSONReader::JSON_SYNTAX_ERROR;
+    return false;
+  }
+
+  // Roughly one token per eight bytes is typical for pretty-printed input.
+  offsets_.reserve(json.size() / 8 + 1);
+
+  const char* data = json.data();
+  size_t full_blocks_end = json.size() - json.size() % kBlockSize;
+  for (size_t pos = 0; pos < full_blocks_end; pos += kBlockSize)
+    IndexBlock(data + pos, kBlockSize, static_cast<uint32>(pos));
+  if (full_blocks_end < json.size()) {
+    IndexBlock(data + full_blocks_end, json.size() - full_blocks_end,
+               static_cast<uint32>(full_blocks_end));
+  }
+
+  if (in_string_) {
+    error_code_ = JSONReader::JSON_SYNTAX_ERROR;
+    return false;
+  }
+  return MatchBrackets(json);
+}
+
+void JSONStructuralIndex::IndexBlock(const char* block,
+                                     size_t length,
+                                     uint32 base) {
+  BlockMasks masks;
+  if (length == kBlockSize) {
+    ClassifyBlock(block, &masks);
+  } else {
+    // Pad the tail with whitespace, which never starts a token.
+    char padded[kBlockSize];
+    memset(padded, ' ', kBlockSize);
+    memcpy(padded, block, length);
+    ClassifyBlock(padded, &masks);
+  }
+  uint64 valid = length == kBlockSize ?
+      ~static_cast<uint64>(0) : (static_cast<uint64>(1) << length) - 1;
+
+  // Backslashes are rare, so resolve escapes with a scalar walk that only runs
+  // for blocks containing (or starting with) one.
+  uint64 escaped = 0;
+  if (masks.backslash || escape_next_) {
+    for (size_t i = 0; i < length; ++i) {
+      uint64 bit = static_cast<uint64>(1) << i;
+      if (escape_next_) {
+        escaped |= bit;
+        escape_next_ = false;
+      } else if (masks.backslash & bit) {
+        escape_next_ = true;
+      }
+    }
+  }
+
+  uint64 quotes = masks.quote & ~escaped;
+  uint64 inside = PrefixXor(quotes);
+  if (in_string_)
+    inside = ~inside;
+  in_string_ = (inside >> 63) != 0;
+
+  uint64 structural = masks.structural & ~inside;
+  uint64 opening_quotes = quotes & inside;
+  uint64 scalar = ~(masks.structural | masks.whitespace | masks.quote) &
+      ~inside & valid;
+  uint64 scalar_starts =
+      scalar & ~((scalar << 1) | (previous_was_scalar_ ? 1 : 0));
+  previous_was_scalar_ = ((scalar >> (length - 1)) & 1) != 0;
+
+  uint64 tokens = structural | opening_quotes | scalar_starts;
+  while (tokens) {
+    offsets_.push_back(base + CountTrailingZeros(tokens));
+    tokens &= tokens - 1;
+  }
+}
+
+JSONReader::JsonParseError JSONStructuralIndex::ErrorAtContainerEnd(
+    const StringPiece& json,
+    uint32 open_token,
+    size_t token) const {
+  // JSONParser reports what it expected to find at |token|.
+  char previous = json[offsets_[token - 1]];
+  bool in_dictionary = json[offsets_[open_token]] == '{';
+  if (previous == '{' || (previous == ',' && in_dictionary))
+    return JSONReader::JSON_UNQUOTED_DICTIONARY_KEY;
+  if (previous == '[' || previous == ',' || previous == ':')
+    return JSONReader::JSON_UNEXPECTED_TOKEN;
+  return JSONReader::JSON_SYNTAX_ERROR;
+}
+
+bool JSONStructuralIndex::MatchBrackets(const StringPiece& json) {
+  matches_.assign(offsets_.size(), kNoMatch);
+  std::vector<uint32> open;
+  for (size_t i = 0; i < offsets_.size(); ++i) {
+    char c = json[offsets_[i]];
+    if (c == '{' || c == '[') {
+      if (open.size() + 1 >= kMaxDepth) {
+        error_code_ = JSONReader::JSON_TOO_MUCH_NESTING;
+        return false;
+      }
+      open.push_back(static_cast<uint32>(i));
+    } else if (c == '}' || c == ']') {
+      if (open.empty()) {
+        // Like JSONParser, a stray closing bracket after a complete value is
+        // reported as data after the root.
+        error_code_ = i == 0 ? JSONReader::JSON_UNEXPECTED_TOKEN :
+            JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT;
+        return false;
+      }
+      if (json[offsets_[open.back()]] != (c == '}' ? '{' : '[')) {
+        error_code_ = ErrorAtContainerEnd(json, open.back(), i);
+        return false;
+      }
+      matches_[open.back()] = static_cast<uint32>(i);
+      matches_[i] = open.back();
+      open.pop_back();
+    }
+  }
+  if (!open.empty()) {
+    error_code_ = ErrorAtContainerEnd(json, open.back(), offsets_.size());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace internal
+}  // namespace base
@@ -0,0 +1,103 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// JSONStructuralIndex is the first stage of a two-stage JSON parser in the
+// style of simdjson. It classifies the input 64 bytes at a time (with SSE2
+// where available) and records the offset of every token that starts a JSON
+// element or separates elements: the structural characters {}[]:, outside of
+// strings, the opening quote of every string, and the first character of every
+// number or literal. Brackets are matched in the same pass, so consumers can
+// skip over a nested object or array in constant time.
+//
+// The index does not validate the grammar between tokens; it only guarantees
+// that strings are terminated and that brackets balance. See JSONLazyDocument
+// for a reader built on top of it.
+
+#ifndef BASE_JSON_JSON_STRUCTURAL_INDEX_H_
+#define BASE_JSON_JSON_STRUCTURAL_INDEX_H_
+
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/json/json_reader.h"
+#include "base/strings/string_piece.h"
+
+namespace base {
+namespace internal {
+
+// Returns the number of bytes at the beginning of [|begin|, |end|) that can be
+// copied verbatim into a decoded JSON string: ASCII characters other than '"'
+// and '\\'. Vectorized where possible.
+BASE_EXPORT_PRIVATE size_t CountPlainStringBytes(const char* begin,
+                                                 const char* end);
+
+// Returns the offset one past the closing quote of the string whose opening
+// quote is at |offset| in |json|. The string must be terminated, which
+// JSONStructuralIndex::Build() guarantees for every indexed string.
+BASE_EXPORT_PRIVATE size_t FindStringEnd(const StringPiece& json,
+                                         size_t offset);
+
+// Returns the offset one past the end of the string, number or literal that
+// starts at |offset| in |json|. Numbers and literals end at the next
+// structural character or whitespace; they are not validated.
+BASE_EXPORT_PRIVATE size_t ScalarEnd(const StringPiece& json, size_t offset);
+
+class BASE_EXPORT_PRIVATE JSONStructuralIndex {
+ public:
+  // Sentinel stored in the bracket match table for non-bracket tokens.
+  static const uint32 kNoMatch = 0xFFFFFFFFu;
+
+  JSONStructuralIndex();
+  ~JSONStructuralIndex();
+
+  // Indexes |json|, replacing any previous contents. Returns false and sets
+  // error_code() if a string is unterminated, brackets do not balance or nest
+  // too deeply, or the input is too large to index.
+  bool Build(const StringPiece& json);
+
+  JSONReader::JsonParseError error_code() const { return error_code_; }
+
+  // Number of indexed tokens.
+  size_t size() const { return offsets_.size(); }
+
+  // Byte offset of token |i| in the input.
+  uint32 offset(size_t i) const { return offsets_[i]; }
+
+  // For an opening bracket at token |i|, the token index of the matching
+  // closing bracket (and vice versa). kNoMatch for all other tokens.
+  uint32 match(size_t i) const { return matches_[i]; }
+
+ private:
+  // Classifies one block of up to 64 bytes starting at |block| and appends the
+  // offsets of its tokens. |base| is the offset of |block| in the input.
+  void IndexBlock(const char* block, size_t length, uint32 base);
+
+  // Fills |matches_| and checks nesting. Returns false on imbalance.
+  bool MatchBrackets(const StringPiece& json);
+
+  // Returns the error for the container opened at |open_token| ending at
+  // |token|, which is a mismatched closing bracket or the end of the input.
+  // The codes match JSONParser's.
+  JSONReader::JsonParseError ErrorAtContainerEnd(const StringPiece& json,
+                                                 uint32 open_token,
+                                                 size_t token) const;
+
+  std::vector<uint32> offsets_;
+  std::vector<uint32> matches_;
+
+  // State carried from one block to the next.
+  bool in_string_;
+  bool escape_next_;
+  bool previous_was_scalar_;
+
+  JSONReader::JsonParseError error_code_;
+
+  DISALLOW_COPY_AND_ASSIGN(JSONStructuralIndex);
+};
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_STRUCTURAL_INDEX_H_
@@ -0,0 +1,114 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_structural_index.h"
+
+#include <string>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+// Returns the first character of every token, for easy comparison.
+std::string TokenChars(const JSONStructuralIndex& index,
+                       const std::string& json) {
+  std::string chars;
+  for (size_t i = 0; i < index.size(); ++i)
+    chars.push_back(json[index.offset(i)]);
+  return chars;
+}
+
+}  // namespace
+
+TEST(JSONStructuralIndexTest, Tokens) {
+  std::string json("{\"a\": [1, -2.5e3, true], \"b\" :null , \"c\":\"x\"}");
+  JSONStructuralIndex index;
+  ASSERT_TRUE(index.Build(json));
+  EXPECT_EQ("{\":[1,-,t],\":n,\":\"}", TokenChars(index, json));
+
+  // Brackets are matched both ways.
+  EXPECT_EQ(index.size() - 1, index.match(0));
+  EXPECT_EQ(0u, index.match(index.size() - 1));
+  EXPECT_EQ(9u, index.match(3));
+  EXPECT_EQ(3u, index.match(9));
+  EXPECT_EQ(JSONStructuralIndex::kNoMatch, index.match(1));
+}
+
+TEST(JSONStructuralIndexTest, StringContents) {
+  // Structural characters, escaped quotes and backslashes inside strings must
+  // not produce tokens.
+  std::string json("[\"{[,:]}\", \"\\\"]\", \"\\\\\", \"a\\\\\\\"b\"]");
+  JSONStructuralIndex index;
+  ASSERT_TRUE(index.Build(json));
+  EXPECT_EQ("[\",\",\",\"]", TokenChars(index, json));
+}
+
+TEST(JSONStructuralIndexTest, BlockBoundaries) {
+  // Move a string with an escape at the end across the 64-byte block boundary.
+  for (size_t padding = 50; padding < 80; ++padding) {
+    std::string json = "[" + std::string(padding, ' ') +
+        "\"abc\\\\\", \"\\\"\", 12345]";
+    JSONStructuralIndex index;
+    ASSERT_TRUE(index.Build(json)) << padding;
+    EXPECT_EQ("[\",\",1]", TokenChars(index, json)) << padding;
+  }
+
+  // A number spanning two blocks is one token.
+  std::string json = "[" + std::string(62, ' ') + "123456]";
+  JSONStructuralIndex index;
+  ASSERT_TRUE(index.Build(json));
+  EXPECT_EQ("[1]", TokenChars(index, json));
+}
+
+TEST(JSONStructuralIndexTest, Errors) {
+  JSONStructuralIndex index;
+  EXPECT_FALSE(index.Build("[\"abc]"));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, index.error_code());
+  EXPECT_FALSE(index.Build("[\"abc\\\"]"));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, index.error_code());
+  EXPECT_FALSE(index.Build("[1, 2}"));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, index.error_code());
+  EXPECT_FALSE(index.Build("[[]"));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, index.error_code());
+
+  // Other bracket errors get the codes JSONParser would report.
+  EXPECT_FALSE(index.Build("{\"a\": [}"));
+  EXPECT_EQ(JSONReader::JSON_UNEXPECTED_TOKEN, index.error_code());
+  EXPECT_FALSE(index.Build("[{]"));
+  EXPECT_EQ(JSONReader::JSON_UNQUOTED_DICTIONARY_KEY, index.error_code());
+  EXPECT_FALSE(index.Build("[1,"));
+  EXPECT_EQ(JSONReader::JSON_UNEXPECTED_TOKEN, index.error_code());
+  EXPECT_FALSE(index.Build("]"));
+  EXPECT_EQ(JSONReader::JSON_UNEXPECTED_TOKEN, index.error_code());
+  EXPECT_FALSE(index.Build("[1]]"));
+  EXPECT_EQ(JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT, index.error_code());
+
+  // Like JSONParser, 99 levels of nesting are allowed but not 100.
+  std::string deep = std::string(100, '[') + std::string(100, ']');
+  EXPECT_FALSE(index.Build(deep));
+  EXPECT_EQ(JSONReader::JSON_TOO_MUCH_NESTING, index.error_code());
+  deep = std::string(99, '[') + std::string(99, ']');
+  EXPECT_TRUE(index.Build(deep));
+  EXPECT_EQ(JSONReader::JSON_NO_ERROR, index.error_code());
+}
+
+TEST(JSONStructuralIndexTest, CountPlainStringBytes) {
+  for (size_t length = 0; length < 40; ++length) {
+    std::string plain(length, 'x');
+    const char* kStops[] = { "\"", "\\", "\xc3\xa9" };
+    for (size_t i = 0; i < arraysize(kStops); ++i) {
+      std::string input = plain + kStops[i] + plain;
+      EXPECT_EQ(length, CountPlainStringBytes(input.data(),
+                                              input.data() + input.size()));
+    }
+    EXPECT_EQ(length, CountPlainStringBytes(plain.data(),
+                                            plain.data() + plain.size()));
+  }
+}
+
+}  // namespace internal
+}  // namespace base
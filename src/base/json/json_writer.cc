@@ -6,6 +6,7 @@
 
 #include <cmath>
 
+#include "base/compact_value.h"
 #include "base/json/string_escape.h"
 #include "base/logging.h"
 #include "base/strings/string_number_conversions.h"
@@ -24,6 +25,94 @@ static const char kPrettyPrintLineEnding[] = "\n";
 /* static */
 const char* JSONWriter::kEmptyArray = "[]";
 
+namespace {
+
+// Adapters for JSONWriter::BuildJSONString(), which walks both Value and
+// CompactValue trees.
+struct ValueAdapter {
+  typedef const Value* Node;
+
+  class DictionaryIterator {
+   public:
+    explicit DictionaryIterator(Node node)
+        : iterator_(*static_cast<const DictionaryValue*>(node)) {}
+
+    bool IsAtEnd() const { return iterator_.IsAtEnd(); }
+    void Advance() { iterator_.Advance(); }
+    StringPiece key() const { return iterator_.key(); }
+    Node value() const { return &iterator_.value(); }
+
+   private:
+    DictionaryValue::Iterator iterator_;
+  };
+
+  static Value::Type GetType(Node node) { return node->GetType(); }
+  static bool GetAsBoolean(Node node, bool* value) {
+    return node->GetAsBoolean(value);
+  }
+  static bool GetAsInteger(Node node, int* value) {
+    return node->GetAsInteger(value);
+  }
+  static bool GetAsDouble(Node node, double* value) {
+    return node->GetAsDouble(value);
+  }
+  // |storage| keeps the string alive while |value| points into it.
+  static bool GetAsString(Node node, std::string* storage,
+                          StringPiece* value) {
+    bool result = node->GetAsString(storage);
+    *value = *storage;
+    return result;
+  }
+  static size_t GetListSize(Node node) {
+    return static_cast<const ListValue*>(node)->GetSize();
+  }
+  static Node GetListItem(Node node, size_t index) {
+    const Value* value = NULL;
+    bool result = static_cast<const ListValue*>(node)->Get(index, &value);
+    DCHECK(result);
+    return value;
+  }
+};
+
+struct CompactValueAdapter {
+  typedef const CompactValue* Node;
+
+  class DictionaryIterator {
+   public:
+    explicit DictionaryIterator(Node node) : node_(node), index_(0) {}
+
+    bool IsAtEnd() const { return index_ >= node_->size(); }
+    void Advance() { ++index_; }
+    StringPiece key() const { return node_->GetDictionaryEntry(index_)->key(); }
+    Node value() const { return &node_->GetDictionaryEntry(index_)->value; }
+
+   private:
+    Node node_;
+    size_t index_;
+  };
+
+  static Value::Type GetType(Node node) { return node->GetType(); }
+  static bool GetAsBoolean(Node node, bool* value) {
+    return node->GetAsBoolean(value);
+  }
+  static bool GetAsInteger(Node node, int* value) {
+    return node->GetAsInteger(value);
+  }
+  static bool GetAsDouble(Node node, double* value) {
+    return node->GetAsDouble(value);
+  }
+  static bool GetAsString(Node node, std::string* storage,
+                          StringPiece* value) {
+    return node->GetAsString(value);
+  }
+  static size_t GetListSize(Node node) { return node->size(); }
+  static Node GetListItem(Node node, size_t index) {
+    return node->GetListItem(index);
+  }
+};
+
+}  // namespace
+
 /* static */
 void JSONWriter::Write(const Value* const node, std::string* json) {
   WriteWithOptions(node, 0, json);
@@ -32,6 +121,19 @@ void JSONWriter::Write(const Value* const node, std::string* json) {
 /* static */
 void JSONWriter::WriteWithOptions(const Value* const node, int options,
                                   std::string* json) {
+  WriteTree<ValueAdapter>(node, options, json);
+}
+
+/* static */
+void JSONWriter::WriteCompact(const CompactValue& node, int options,
+                              std::string* json) {
+  WriteTree<CompactValueAdapter>(&node, options, json);
+}
+
+/* static */
+template <typename Adapter>
+void JSONWriter::WriteTree(typename Adapter::Node node, int options,
+                           std::string* json) {
   json->clear();
   // Is there a better way to estimate the size of the output?
   json->reserve(1024);
@@ -44,7 +146,7 @@ void JSONWriter::WriteWithOptions(const Value* const node, int options,
 
   JSONWriter writer(escape, omit_binary_values, omit_double_type_preservation,
                     pretty_print, json);
-  writer.BuildJSONString(node, 0);
+  writer.BuildJSONString<Adapter>(node, 0);
 
   if (pretty_print)
     json->append(kPrettyPrintLineEnding);
@@ -61,8 +163,9 @@ JSONWriter::JSONWriter(bool escape, bool omit_binary_values,
   DCHECK(json);
 }
 
-void JSONWriter::BuildJSONString(const Value* const node, int depth) {
-  switch (node->GetType()) {
+template <typename Adapter>
+void JSONWriter::BuildJSONString(typename Adapter::Node node, int depth) {
+  switch (Adapter::GetType(node)) {
     case Value::TYPE_NULL:
       json_string_->append("null");
       break;
@@ -70,7 +173,7 @@ void JSONWriter::BuildJSONString(const Value* const node, int depth) {
     case Value::TYPE_BOOLEAN:
       {
         bool value;
-        bool result = node->GetAsBoolean(&value);
+        bool result = Adapter::GetAsBoolean(node, &value);
         DCHECK(result);
         json_string_->append(value ? "true" : "false");
         break;
@@ -79,7 +182,7 @@ void JSONWriter::BuildJSONString(const Value* const node, int depth) {
     case Value::TYPE_INTEGER:
       {
         int value;
-        bool result = node->GetAsInteger(&value);
+        bool result = Adapter::GetAsInteger(node, &value);
         DCHECK(result);
         base::StringAppendF(json_string_, "%d", value);
         break;
@@ -88,46 +191,19 @@ void JSONWriter::BuildJSONString(const Value* const node, int depth) {
     case Value::TYPE_DOUBLE:
       {
         double value;
-        bool result = node->GetAsDouble(&value);
+        bool result = Adapter::GetAsDouble(node, &value);
         DCHECK(result);
-        if (omit_double_type_preservation_ &&
-            value <= kint64max &&
-            value >= kint64min &&
-            std::floor(value) == value) {
-          json_string_->append(Int64ToString(static_cast<int64>(value)));
-          break;
-        }
-        std::string real = DoubleToString(value);
-        // Ensure that the number has a .0 if there's no decimal or 'e'.  This
-        // makes sure that when we read the JSON back, it's interpreted as a
-        // real rather than an int.
-        if (real.find('.') == std::string::npos &&
-            real.find('e') == std::string::npos &&
-            real.find('E') == std::string::npos) {
-          real.append(".0");
-        }
-        // The JSON spec requires that non-integer values in the range (-1,1)
-        // have a zero before the decimal point - ".52" is not valid, "0.52" is.
-        if (real[0] == '.') {
-          real.insert(0, "0");
-        } else if (real.length() > 1 && real[0] == '-' && real[1] == '.') {
-          // "-.1" bad "-0.1" good
-          real.insert(1, "0");
-        }
-        json_string_->append(real);
+        AppendDouble(value);
         break;
       }
 
     case Value::TYPE_STRING:
       {
-        std::string value;
-        bool result = node->GetAsString(&value);
+        std::string storage;
+        StringPiece value;
+        bool result = Adapter::GetAsString(node, &storage, &value);
         DCHECK(result);
-        if (escape_) {
-          JsonDoubleQuote(UTF8ToUTF16(value), true, json_string_);
-        } else {
-          JsonDoubleQuote(value, true, json_string_);
-        }
+        AppendQuotedString(value, escape_);
         break;
       }
 
@@ -137,23 +213,22 @@ void JSONWriter::BuildJSONString(const Value* const node, int depth) {
         if (pretty_print_)
           json_string_->append(" ");
 
-        const ListValue* list = static_cast<const ListValue*>(node);
-        for (size_t i = 0; i < list->GetSize(); ++i) {
-          const Value* value = NULL;
-          bool result = list->Get(i, &value);
-          DCHECK(result);
-
-          if (omit_binary_values_ && value->GetType() == Value::TYPE_BINARY) {
+        bool first_entry = true;
+        for (size_t i = 0; i < Adapter::GetListSize(node); ++i) {
+          typename Adapter::Node value = Adapter::GetListItem(node, i);
+          if (omit_binary_values_ &&
+              Adapter::GetType(value) == Value::TYPE_BINARY) {
             continue;
           }
 
-          if (i != 0) {
+          if (!first_entry) {
             json_string_->append(",");
             if (pretty_print_)
               json_string_->append(" ");
           }
+          first_entry = false;
 
-          BuildJSONString(value, depth);
+          BuildJSONString<Adapter>(value, depth);
         }
 
         if (pretty_print_)
@@ -168,13 +243,11 @@ void JSONWriter::BuildJSONString(const Value* const node, int depth) {
         if (pretty_print_)
           json_string_->append(kPrettyPrintLineEnding);
 
-        const DictionaryValue* dict =
-          static_cast<const DictionaryValue*>(node);
         bool first_entry = true;
-        for (DictionaryValue::Iterator itr(*dict); !itr.IsAtEnd();
-             itr.Advance(), first_entry = false) {
+        for (typename Adapter::DictionaryIterator itr(node); !itr.IsAtEnd();
+             itr.Advance()) {
           if (omit_binary_values_ &&
-              itr.value().GetType() == Value::TYPE_BINARY) {
+              Adapter::GetType(itr.value()) == Value::TYPE_BINARY) {
             continue;
           }
 
@@ -183,16 +256,17 @@ void JSONWriter::BuildJSONString(const Value* const node, int depth) {
             if (pretty_print_)
               json_string_->append(kPrettyPrintLineEnding);
           }
+          first_entry = false;
 
           if (pretty_print_)
             IndentLine(depth + 1);
-          AppendQuotedString(itr.key());
+          AppendQuotedString(itr.key(), true);
           if (pretty_print_) {
             json_string_->append(": ");
           } else {
             json_string_->append(":");
           }
-          BuildJSONString(&itr.value(), depth + 1);
+          BuildJSONString<Adapter>(itr.value(), depth + 1);
         }
 
         if (pretty_print_) {
@@ -218,10 +292,56 @@ void JSONWriter::BuildJSONString(const Value* const node, int depth) {
   }
 }
 
-void JSONWriter::AppendQuotedString(const std::string& str) {
+void JSONWriter::AppendDouble(double value) {
+  if (omit_double_type_preservation_ &&
+      value <= kint64max &&
+      value >= kint64min &&
+      std::floor(value) == value) {
+    json_string_->append(Int64ToString(static_cast<int64>(value)));
+    return;
+  }
+  std::string real = DoubleToString(value);
+  // Ensure that the number has a .0 if there's no decimal or 'e'.  This
+  // makes sure that when we read the JSON back, it's interpreted as a
+  // real rather than an int.
+  if (real.find('.') == std::string::npos &&
+      real.find('e') == std::string::npos &&
+      real.find('E') == std::string::npos) {
+    real.append(".0");
+  }
+  // The JSON spec requires that non-integer values in the range (-1,1)
+  // have a zero before the decimal point - ".52" is not valid, "0.52" is.
+  if (real[0] == '.') {
+    real.insert(0, "0");
+  } else if (real.length() > 1 && real[0] == '-' && real[1] == '.') {
+    // "-.1" bad "-0.1" good
+    real.insert(1, "0");
+  }
+  json_string_->append(real);
+}
+
+void JSONWriter::AppendQuotedString(const StringPiece& str, bool escape) {
+  // Most strings are printable ASCII that JsonDoubleQuote() would copy
+  // verbatim; skip the conversions for those.
+  bool verbatim = true;
+  for (size_t i = 0; i < str.size() && verbatim; ++i) {
+    char c = str[i];
+    verbatim = c >= 32 && c <= 126 && c != '"' && c != '\\' && c != '<' &&
+        c != '>';
+  }
+  if (verbatim) {
+    json_string_->push_back('"');
+    json_string_->append(str.data(), str.size());
+    json_string_->push_back('"');
+    return;
+  }
+
   // TODO(viettrungluu): |str| is UTF-8, not ASCII, so to properly escape it we
   // have to convert it to UTF-16. This round-trip is suboptimal.
-  JsonDoubleQuote(UTF8ToUTF16(str), true, json_string_);
+  if (escape)
+    JsonDoubleQuote(UTF8ToUTF16(str), true, json_string_);
+  else
+    JsonDoubleQuote(str.as_string(), true, json_string_);
 }
 
 void JSONWriter::IndentLine(int depth) {
@@ -9,9 +9,11 @@
 
 #include "base/base_export.h"
 #include "base/basictypes.h"
+#include "base/strings/string_piece.h"
 
 namespace base {
 
+class CompactValue;
 class Value;
 
 class BASE_EXPORT JSONWriter {
@@ -48,6 +50,11 @@ class BASE_EXPORT JSONWriter {
   static void WriteWithOptions(const Value* const node, int options,
                                std::string* json);
 
+  // Same as WriteWithOptions() but for a CompactValue tree. The output is
+  // identical to that for the equivalent base::Value.
+  static void WriteCompact(const CompactValue& node, int options,
+                           std::string* json);
+
   // A static, constant JSON string representing an empty array.  Useful
   // for empty JSON argument passing.
   static const char* kEmptyArray;
@@ -57,12 +64,24 @@ class BASE_EXPORT JSONWriter {
              bool omit_double_type_preservation, bool pretty_print,
              std::string* json);
 
+  // Writes the tree rooted at |node| to |json|. |Adapter| gives uniform access
+  // to Value and CompactValue trees so that both produce the same output; see
+  // json_writer.cc.
+  template <typename Adapter>
+  static void WriteTree(typename Adapter::Node node, int options,
+                        std::string* json);
+
   // Called recursively to build the JSON string.  Whe completed, value is
   // json_string_ will contain the JSON.
-  void BuildJSONString(const Value* const node, int depth);
+  template <typename Adapter>
+  void BuildJSONString(typename Adapter::Node node, int depth);
+
+  // Appends the JSON representation of |value| to json_string_.
+  void AppendDouble(double value);
 
-  // Appends a quoted, escaped, version of (UTF-8) str to json_string_.
-  void AppendQuotedString(const std::string& str);
+  // Appends a quoted version of (UTF-8) str to json_string_. Non-ASCII
+  // characters are only escaped if |escape| is true.
+  void AppendQuotedString(const StringPiece& str, bool escape);
 
   // Adds space to json_string_ for the indent level.
   void IndentLine(int depth);
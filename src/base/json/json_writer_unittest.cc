@@ -119,6 +119,23 @@ TEST(JSONWriterTest, Writing) {
                                &output_js);
   ASSERT_EQ("{\"a\":5,\"c\":2}", output_js);
 
+  // An omitted first element does not leave a leading separator.
+  ListValue leading_binary_list;
+  leading_binary_list.Append(BinaryValue::CreateWithCopiedBuffer("asdf", 4));
+  leading_binary_list.Append(new FundamentalValue(5));
+  JSONWriter::WriteWithOptions(&leading_binary_list,
+                               JSONWriter::OPTIONS_OMIT_BINARY_VALUES,
+                               &output_js);
+  ASSERT_EQ("[5]", output_js);
+
+  DictionaryValue leading_binary_dict;
+  leading_binary_dict.Set("a", BinaryValue::CreateWithCopiedBuffer("asdf", 4));
+  leading_binary_dict.Set("b", new FundamentalValue(5));
+  JSONWriter::WriteWithOptions(&leading_binary_dict,
+                               JSONWriter::OPTIONS_OMIT_BINARY_VALUES,
+                               &output_js);
+  ASSERT_EQ("{\"b\":5}", output_js);
+
   // Test allowing a double with no fractional part to be written as an integer.
   FundamentalValue double_value(1e10);
   JSONWriter::WriteWithOptions(
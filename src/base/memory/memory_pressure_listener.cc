@@ -4,6 +4,7 @@
 
 #include "base/memory/memory_pressure_listener.h"
 
+#include "base/callback_internal.h"
 #include "base/lazy_instance.h"
 #include "base/observer_list_threadsafe.h"
 
@@ -50,6 +51,7 @@ void MemoryPressureListener::Notify(MemoryPressureLevel memory_pressure_level) {
 // static
 void MemoryPressureListener::NotifyMemoryPressure(
     MemoryPressureLevel memory_pressure_level) {
+  internal::BindStateBase::ReleaseFreeBlocks();
   g_observers.Get().Notify(&MemoryPressureListener::Notify,
                            memory_pressure_level);
 }
@@ -8,13 +8,26 @@
 #include "base/location.h"
 #include "base/message_loop/message_loop.h"
 #include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
 
 namespace base {
 namespace internal {
 
+namespace {
+
+// Layout of |posting_state_|.
+const subtle::Atomic32 kExclusiveBit = 1;
+const subtle::Atomic32 kPosterIncrement = 2;
+
+}  // namespace
+
 IncomingTaskQueue::IncomingTaskQueue(MessageLoop* message_loop)
-    : message_loop_(message_loop),
+    : posting_state_(0),
+      message_loop_(message_loop),
       next_sequence_num_(0) {
+#if defined(OS_WIN)
+  subtle::NoBarrier_Store(&high_resolution_timer_active_, 0);
+#endif
 }
 
 bool IncomingTaskQueue::AddToIncomingQueue(
@@ -22,25 +35,28 @@ bool IncomingTaskQueue::AddToIncomingQueue(
     const Closure& task,
     TimeDelta delay,
     bool nestable) {
-  AutoLock locked(incoming_queue_lock_);
+  BeginPosting(true);
   PendingTask pending_task(
       from_here, task, CalculateDelayedRuntime(delay), nestable);
-  return PostPendingTask(&pending_task);
+  bool result = PostPendingTask(&pending_task);
+  EndPosting();
+  return result;
 }
 
 bool IncomingTaskQueue::TryAddToIncomingQueue(
     const tracked_objects::Location& from_here,
     const Closure& task) {
-  if (!incoming_queue_lock_.Try()) {
+  if (!BeginPosting(false)) {
     // Reset |task|.
     Closure local_task = task;
     return false;
   }
 
-  AutoLock locked(incoming_queue_lock_, AutoLock::AlreadyAcquired());
   PendingTask pending_task(
       from_here, task, CalculateDelayedRuntime(TimeDelta()), true);
-  return PostPendingTask(&pending_task);
+  bool result = PostPendingTask(&pending_task);
+  EndPosting();
+  return result;
 }
 
 bool IncomingTaskQueue::IsHighResolutionTimerEnabledForTesting() {
@@ -52,27 +68,23 @@ bool IncomingTaskQueue::IsHighResolutionTimerEnabledForTesting() {
 }
 
 bool IncomingTaskQueue::IsIdleForTesting() {
-  AutoLock lock(incoming_queue_lock_);
-  return incoming_queue_.empty();
+  return incoming_queue_.IsEmpty();
 }
 
 void IncomingTaskQueue::LockWaitUnLockForTesting(WaitableEvent* caller_wait,
                                                  WaitableEvent* caller_signal) {
-  AutoLock lock(incoming_queue_lock_);
+  BeginExclusiveAccess();
   caller_wait->Signal();
   caller_signal->Wait();
+  EndExclusiveAccess();
 }
 
 void IncomingTaskQueue::ReloadWorkQueue(TaskQueue* work_queue) {
   // Make sure no tasks are lost.
   DCHECK(work_queue->empty());
 
-  // Acquire all we can from the inter-thread queue with one lock acquisition.
-  AutoLock lock(incoming_queue_lock_);
-  if (!incoming_queue_.empty())
-    incoming_queue_.Swap(work_queue);  // Constant time
-
-  DCHECK(incoming_queue_.empty());
+  // Acquire all we can from the inter-thread queue with one atomic exchange.
+  incoming_queue_.PopAll(work_queue);
 }
 
 void IncomingTaskQueue::WillDestroyCurrentMessageLoop() {
@@ -83,11 +95,15 @@ void IncomingTaskQueue::WillDestroyCurrentMessageLoop() {
   if (!high_resolution_timer_expiration_.is_null()) {
     Time::ActivateHighResolutionTimer(false);
     high_resolution_timer_expiration_ = TimeTicks();
+    subtle::Release_Store(&high_resolution_timer_active_, 0);
   }
 #endif
 
-  AutoLock lock(incoming_queue_lock_);
+  // Wait for threads that are in the middle of posting, since they may still
+  // call into |message_loop_|.
+  BeginExclusiveAccess();
   message_loop_ = NULL;
+  EndExclusiveAccess();
 }
 
 IncomingTaskQueue::~IncomingTaskQueue() {
@@ -99,8 +115,21 @@ TimeTicks IncomingTaskQueue::CalculateDelayedRuntime(TimeDelta delay) {
   TimeTicks delayed_run_time;
   if (delay > TimeDelta()) {
     delayed_run_time = TimeTicks::Now() + delay;
+  } else {
+    DCHECK_EQ(delay.InMilliseconds(), 0) << "delay should not be negative";
+  }
 
 #if defined(OS_WIN)
+  // Most tasks have no delay. They only take the lock to end an expired
+  // high resolution timer lease, so skip it while no lease is held. A lease
+  // taken concurrently with this post is ended by a later one.
+  if (delay <= TimeDelta() &&
+      !subtle::Acquire_Load(&high_resolution_timer_active_)) {
+    return delayed_run_time;
+  }
+
+  AutoLock lock(high_resolution_timer_lock_);
+  if (delay > TimeDelta()) {
     if (high_resolution_timer_expiration_.is_null()) {
       // Windows timers are granular to 15.6ms.  If we only set high-res
       // timers for those under 15.6ms, then a 18ms timer ticks at ~32ms,
@@ -114,19 +143,17 @@ TimeTicks IncomingTaskQueue::CalculateDelayedRuntime(TimeDelta delay) {
           high_resolution_timer_expiration_ = TimeTicks::Now() +
               TimeDelta::FromMilliseconds(
                   MessageLoop::kHighResolutionTimerModeLeaseTimeMs);
+          subtle::Release_Store(&high_resolution_timer_active_, 1);
         }
       }
     }
-#endif
-  } else {
-    DCHECK_EQ(delay.InMilliseconds(), 0) << "delay should not be negative";
   }
 
-#if defined(OS_WIN)
   if (!high_resolution_timer_expiration_.is_null()) {
     if (TimeTicks::Now() > high_resolution_timer_expiration_) {
       Time::ActivateHighResolutionTimer(false);
       high_resolution_timer_expiration_ = TimeTicks();
+      subtle::Release_Store(&high_resolution_timer_active_, 0);
     }
   }
 #endif
@@ -139,8 +166,8 @@ bool IncomingTaskQueue::PostPendingTask(PendingTask* pending_task) {
   // directly, as it could starve handling of foreign threads.  Put every task
   // into this queue.
 
-  // This should only be called while the lock is taken.
-  incoming_queue_lock_.AssertAcquired();
+  // This should only be called while posting is registered.
+  DCHECK_GE(subtle::NoBarrier_Load(&posting_state_), kPosterIncrement);
 
   if (!message_loop_) {
     pending_task->task.Reset();
@@ -150,20 +177,60 @@ bool IncomingTaskQueue::PostPendingTask(PendingTask* pending_task) {
   // Initialize the sequence number. The sequence number is used for delayed
   // tasks (to faciliate FIFO sorting when two tasks have the same
   // delayed_run_time value) and for identifying the task in about:tracing.
-  pending_task->sequence_num = next_sequence_num_++;
+  pending_task->sequence_num =
+      subtle::NoBarrier_AtomicIncrement(&next_sequence_num_, 1) - 1;
 
   TRACE_EVENT_FLOW_BEGIN0("task", "MessageLoop::PostTask",
       TRACE_ID_MANGLE(message_loop_->GetTaskTraceID(*pending_task)));
 
-  bool was_empty = incoming_queue_.empty();
-  incoming_queue_.push(*pending_task);
-  pending_task->task.Reset();
+  // |*pending_task| is left holding the queue's empty default task.
+  bool was_empty = incoming_queue_.PushByTransfer(pending_task);
 
-  // Wake up the pump.
+  // Wake up the pump. This happens after the push so that the loop is
+  // guaranteed to find the task once it wakes up.
   message_loop_->ScheduleWork(was_empty);
 
   return true;
 }
 
+bool IncomingTaskQueue::BeginPosting(bool wait) {
+  for (;;) {
+    subtle::Atomic32 state =
+        subtle::Barrier_AtomicIncrement(&posting_state_, kPosterIncrement);
+    if (!(state & kExclusiveBit))
+      return true;
+    // Back off and let the exclusive holder finish.
+    subtle::Barrier_AtomicIncrement(&posting_state_, -kPosterIncrement);
+    if (!wait)
+      return false;
+    while (subtle::Acquire_Load(&posting_state_) & kExclusiveBit)
+      PlatformThread::YieldCurrentThread();
+  }
+}
+
+void IncomingTaskQueue::EndPosting() {
+  subtle::Barrier_AtomicIncrement(&posting_state_, -kPosterIncrement);
+}
+
+void IncomingTaskQueue::BeginExclusiveAccess() {
+  for (;;) {
+    subtle::Atomic32 state = subtle::NoBarrier_Load(&posting_state_);
+    if (!(state & kExclusiveBit) &&
+        subtle::Acquire_CompareAndSwap(&posting_state_, state,
+                                       state | kExclusiveBit) == state) {
+      break;
+    }
+    PlatformThread::YieldCurrentThread();
+  }
+  // Posters that registered before the exclusive bit was set finish quickly;
+  // later ones back off on their own.
+  while (subtle::Acquire_Load(&posting_state_) != kExclusiveBit)
+    PlatformThread::YieldCurrentThread();
+}
+
+void IncomingTaskQueue::EndExclusiveAccess() {
+  subtle::Barrier_AtomicIncrement(&posting_state_, -kExclusiveBit);
+}
+
 }  // namespace internal
 }  // namespace base
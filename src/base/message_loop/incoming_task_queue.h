@@ -5,7 +5,9 @@
 #ifndef BASE_MESSAGE_LOOP_INCOMING_TASK_QUEUE_H_
 #define BASE_MESSAGE_LOOP_INCOMING_TASK_QUEUE_H_
 
+#include "base/atomicops.h"
 #include "base/base_export.h"
+#include "base/containers/mpsc_queue.h"
 #include "base/memory/ref_counted.h"
 #include "base/pending_task.h"
 #include "base/synchronization/lock.h"
@@ -18,9 +20,27 @@ class WaitableEvent;
 
 namespace internal {
 
+// Hands tasks into the incoming queue, and from there to the work queue, by
+// swapping.
+struct PendingTaskTransferTraits {
+  static void Store(PendingTask* task, PendingTask* slot) {
+    slot->Swap(task);
+  }
+
+  static void Transfer(PendingTask* task, TaskQueue* work_queue) {
+    work_queue->PushBySwap(task);
+  }
+};
+
 // Implements a queue of tasks posted to the message loop running on the current
 // thread. This class takes care of synchronizing posting tasks from different
 // threads and together with MessageLoop ensures clean shutdown.
+//
+// Posting is lock-free: tasks are pushed onto an MPSCQueue and posting threads
+// only announce themselves through an atomic counter so that the message loop
+// can be detached safely. Posting threads never wait for each other; they only
+// wait while the queue is being detached from its message loop (or while it is
+// exclusively held by LockWaitUnLockForTesting()).
 class BASE_EXPORT IncomingTaskQueue
     : public RefCountedThreadSafe<IncomingTaskQueue> {
  public:
@@ -38,9 +58,9 @@ class BASE_EXPORT IncomingTaskQueue
                           TimeDelta delay,
                           bool nestable);
 
-  // Same as AddToIncomingQueue() except that it will avoid blocking if the lock
-  // is already held, and will in that case (when the lock is contended) fail to
-  // add the task, and will return false.
+  // Same as AddToIncomingQueue() except that it will avoid blocking if the
+  // queue is exclusively held, and will in that case fail to add the task, and
+  // will return false.
   bool TryAddToIncomingQueue(const tracked_objects::Location& from_here,
                              const Closure& task);
 
@@ -51,8 +71,9 @@ class BASE_EXPORT IncomingTaskQueue
   // Returns true if the message loop is "idle". Provided for testing.
   bool IsIdleForTesting();
 
-  // Takes the incoming queue lock, signals |caller_wait| and waits until
-  // |caller_signal| is signalled.
+  // Takes exclusive hold of the incoming queue, signals |caller_wait| and waits
+  // until |caller_signal| is signalled. Posting blocks (and TryPost fails)
+  // meanwhile.
   void LockWaitUnLockForTesting(WaitableEvent* caller_wait,
                                 WaitableEvent* caller_signal);
 
@@ -73,27 +94,47 @@ class BASE_EXPORT IncomingTaskQueue
   // Adds a task to |incoming_queue_|. The caller retains ownership of
   // |pending_task|, but this function will reset the value of
   // |pending_task->task|. This is needed to ensure that the posting call stack
-  // does not retain |pending_task->task| beyond this function call.
+  // does not retain |pending_task->task| beyond this function call. Must be
+  // called between a successful BeginPosting() and EndPosting().
   bool PostPendingTask(PendingTask* pending_task);
 
+  // Registers the calling thread as a poster. Returns false without
+  // registering if the queue is exclusively held and |wait| is false;
+  // otherwise waits for the exclusive holder to finish.
+  bool BeginPosting(bool wait);
+  void EndPosting();
+
+  // Waits until no thread is posting and keeps new posters out until
+  // EndExclusiveAccess() is called.
+  void BeginExclusiveAccess();
+  void EndExclusiveAccess();
+
 #if defined(OS_WIN)
+  // Protects |high_resolution_timer_expiration_|, which is updated by posting
+  // threads.
+  base::Lock high_resolution_timer_lock_;
   TimeTicks high_resolution_timer_expiration_;
+
+  // Non-zero while |high_resolution_timer_expiration_| is set. Lets posts
+  // without a delay skip |high_resolution_timer_lock_| when no lease is held.
+  volatile subtle::Atomic32 high_resolution_timer_active_;
 #endif
 
-  // The lock that protects access to |incoming_queue_|, |message_loop_| and
-  // |next_sequence_num_|.
-  base::Lock incoming_queue_lock_;
+  // Bit 0 is set while the queue is exclusively held; the remaining bits count
+  // the threads currently inside BeginPosting()/EndPosting().
+  volatile subtle::Atomic32 posting_state_;
 
-  // An incoming queue of tasks that are acquired under a mutex for processing
-  // on this instance's thread. These tasks have not yet been been pushed to
+  // An incoming queue of tasks that are pushed without a lock for processing on
+  // this instance's thread. These tasks have not yet been been pushed to
   // |message_loop_|.
-  TaskQueue incoming_queue_;
+  MPSCQueue<PendingTask, PendingTaskTransferTraits> incoming_queue_;
 
-  // Points to the message loop that owns |this|.
+  // Points to the message loop that owns |this|. Only changed while the queue
+  // is exclusively held.
   MessageLoop* message_loop_;
 
   // The next sequence number to use for delayed tasks.
-  int next_sequence_num_;
+  volatile subtle::Atomic32 next_sequence_num_;
 
   DISALLOW_COPY_AND_ASSIGN(IncomingTaskQueue);
 };
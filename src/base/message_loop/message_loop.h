@@ -182,8 +182,10 @@ class BASE_EXPORT MessageLoop : public MessagePump::Delegate {
   // PostDelayedTask(from_here, task, 0).
   //
   // The TryPostTask is meant for the cases where the calling thread cannot
-  // block. If posting the task will block, the call returns false, the task
-  // is not posted but the task is consumed anyways.
+  // block. Posting is lock-free, so this only fails while the incoming queue
+  // is exclusively held (see LockWaitUnLockForTesting()). In that case the
+  // call returns false, the task is not posted but the task is consumed
+  // anyways.
   //
   // NOTE: These methods may be called on any thread.  The Task will be invoked
   // on the thread that executes MessageLoop::Run().
@@ -395,8 +397,8 @@ class BASE_EXPORT MessageLoop : public MessagePump::Delegate {
   // Returns true if the message loop is "idle". Provided for testing.
   bool IsIdleForTesting();
 
-  // Takes the incoming queue lock, signals |caller_wait| and waits until
-  // |caller_signal| is signalled.
+  // Takes exclusive hold of the incoming queue, signals |caller_wait| and waits
+  // until |caller_signal| is signalled.
   void LockWaitUnLockForTesting(WaitableEvent* caller_wait,
                                 WaitableEvent* caller_signal);
 
@@ -441,11 +443,13 @@ class BASE_EXPORT MessageLoop : public MessagePump::Delegate {
   void RunTask(const PendingTask& pending_task);
 
   // Calls RunTask or queues the pending_task on the deferred task list if it
-  // cannot be run right now.  Returns true if the task was run.
-  bool DeferOrRunPendingTask(const PendingTask& pending_task);
+  // cannot be run right now.  Returns true if the task was run. A deferred
+  // task is swapped into the list, leaving |*pending_task| empty.
+  bool DeferOrRunPendingTask(PendingTask* pending_task);
 
-  // Adds the pending task to delayed_work_queue_.
-  void AddToDelayedWorkQueue(const PendingTask& pending_task);
+  // Swaps the pending task into delayed_work_queue_, leaving |*pending_task|
+  // empty.
+  void AddToDelayedWorkQueue(PendingTask* pending_task);
 
   // Delete tasks that haven't run yet without running them.  Used in the
   // destructor to make sure all the task's destructors get called.  Returns
@@ -0,0 +1,214 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/bind.h"
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop/message_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/test/perftimer.h"
+#include "base/threading/simple_thread.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const int kTasksPerThread = 100000;
+const int kLatencyIterations = 2000;
+const int kSingleThreadTasks = 1000000;
+
+// Counts tasks on the thread running the target loop and signals |done| once
+// |expected| tasks have run.
+class TaskCounter {
+ public:
+  TaskCounter(int expected, WaitableEvent* done)
+      : expected_(expected), count_(0), done_(done) {}
+
+  void Increment() {
+    if (++count_ == expected_)
+      done_->Signal();
+  }
+
+ private:
+  const int expected_;
+  int count_;
+  WaitableEvent* done_;
+};
+
+class Poster : public DelegateSimpleThread::Delegate {
+ public:
+  Poster(MessageLoop* target, TaskCounter* counter, WaitableEvent* go)
+      : target_(target), counter_(counter), go_(go) {}
+
+  virtual void Run() OVERRIDE {
+    go_->Wait();
+    for (int i = 0; i < kTasksPerThread; ++i) {
+      target_->PostTask(FROM_HERE, Bind(&TaskCounter::Increment,
+                                        Unretained(counter_)));
+    }
+  }
+
+ private:
+  MessageLoop* target_;
+  TaskCounter* counter_;
+  WaitableEvent* go_;
+};
+
+void IncrementCounter(int* counter) {
+  ++*counter;
+}
+
+void RecordWakeup(TimeTicks posted_at,
+                  TimeDelta* total_latency,
+                  WaitableEvent* done) {
+  *total_latency += TimeTicks::Now() - posted_at;
+  done->Signal();
+}
+
+// Posts kTasksPerThread tasks from each of |num_threads| threads to a single
+// MessageLoop and reports the aggregate rate.
+void RunPostThroughputTest(int num_threads) {
+  Thread target("target");
+  ASSERT_TRUE(target.Start());
+
+  WaitableEvent go(true, false);
+  WaitableEvent done(false, false);
+  TaskCounter counter(num_threads * kTasksPerThread, &done);
+
+  ScopedVector<Poster> posters;
+  ScopedVector<DelegateSimpleThread> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    posters.push_back(new Poster(target.message_loop(), &counter, &go));
+    threads.push_back(new DelegateSimpleThread(posters[i], "poster"));
+    threads[i]->Start();
+  }
+
+  PerfTimer timer;
+  go.Signal();
+  done.Wait();
+  TimeDelta elapsed = timer.Elapsed();
+
+  for (int i = 0; i < num_threads; ++i)
+    threads[i]->Join();
+  target.Stop();
+
+  LogPerfResult(
+      StringPrintf("MessageLoop_PostTask_%dthreads", num_threads).c_str(),
+      num_threads * kTasksPerThread / elapsed.InSecondsF(), "posts/s");
+}
+
+// Measures the time from posting a task to an idle MessageLoop until the task
+// starts running, while |num_threads| - 1 other threads keep the queue busy.
+void RunWakeupLatencyTest(int num_threads) {
+  Thread target("target");
+  ASSERT_TRUE(target.Start());
+
+  WaitableEvent go(true, false);
+  WaitableEvent background_done(false, false);
+  TaskCounter counter((num_threads - 1) * kTasksPerThread, &background_done);
+
+  ScopedVector<Poster> posters;
+  ScopedVector<DelegateSimpleThread> threads;
+  for (int i = 0; i < num_threads - 1; ++i) {
+    posters.push_back(new Poster(target.message_loop(), &counter, &go));
+    threads.push_back(new DelegateSimpleThread(posters[i], "poster"));
+    threads[i]->Start();
+  }
+  go.Signal();
+
+  TimeDelta total_latency;
+  WaitableEvent ran(false, false);
+  for (int i = 0; i < kLatencyIterations; ++i) {
+    target.message_loop()->PostTask(
+        FROM_HERE,
+        Bind(&RecordWakeup, TimeTicks::Now(), &total_latency, &ran));
+    ran.Wait();
+  }
+
+  if (num_threads > 1)
+    background_done.Wait();
+  for (size_t i = 0; i < threads.size(); ++i)
+    threads[i]->Join();
+  target.Stop();
+
+  LogPerfResult(
+      StringPrintf("MessageLoop_WakeupLatency_%dthreads", num_threads).c_str(),
+      total_latency.InMicroseconds() / static_cast<double>(kLatencyIterations),
+      "us");
+}
+
+}  // namespace
+
+// Cost of binding a small closure and running it, without a message loop.
+TEST(MessageLoopPerfTest, BindAndRunClosure) {
+  int counter = 0;
+  PerfTimer timer;
+  for (int i = 0; i < kSingleThreadTasks; ++i)
+    Bind(&IncrementCounter, &counter).Run();
+  TimeDelta elapsed = timer.Elapsed();
+  EXPECT_EQ(kSingleThreadTasks, counter);
+  LogPerfResult("Closure_BindAndRun",
+                elapsed.InMicroseconds() * 1000.0 / kSingleThreadTasks, "ns");
+}
+
+// Cost of posting a small closure to the current loop and running it there.
+TEST(MessageLoopPerfTest, PostAndRunSameThread) {
+  MessageLoop loop;
+  int counter = 0;
+  PerfTimer timer;
+  for (int i = 0; i < kSingleThreadTasks; ++i)
+    loop.PostTask(FROM_HERE, Bind(&IncrementCounter, &counter));
+  loop.RunUntilIdle();
+  TimeDelta elapsed = timer.Elapsed();
+  EXPECT_EQ(kSingleThreadTasks, counter);
+  LogPerfResult("MessageLoop_PostAndRun",
+                elapsed.InMicroseconds() * 1000.0 / kSingleThreadTasks, "ns");
+}
+
+// Same as above, but posting and running interleave so that the bind state
+// and queue node pools are exercised in steady state.
+TEST(MessageLoopPerfTest, PostAndRunSameThreadInterleaved) {
+  MessageLoop loop;
+  int counter = 0;
+  PerfTimer timer;
+  for (int i = 0; i < kSingleThreadTasks; ++i) {
+    loop.PostTask(FROM_HERE, Bind(&IncrementCounter, &counter));
+    if (i % 64 == 63)
+      loop.RunUntilIdle();
+  }
+  loop.RunUntilIdle();
+  TimeDelta elapsed = timer.Elapsed();
+  EXPECT_EQ(kSingleThreadTasks, counter);
+  LogPerfResult("MessageLoop_PostAndRunInterleaved",
+                elapsed.InMicroseconds() * 1000.0 / kSingleThreadTasks, "ns");
+}
+
+TEST(MessageLoopPerfTest, PostTaskThroughput1Thread) {
+  RunPostThroughputTest(1);
+}
+
+TEST(MessageLoopPerfTest, PostTaskThroughput2Threads) {
+  RunPostThroughputTest(2);
+}
+
+TEST(MessageLoopPerfTest, PostTaskThroughput4Threads) {
+  RunPostThroughputTest(4);
+}
+
+TEST(MessageLoopPerfTest, PostTaskThroughput8Threads) {
+  RunPostThroughputTest(8);
+}
+
+TEST(MessageLoopPerfTest, WakeupLatencyIdle) {
+  RunWakeupLatencyTest(1);
+}
+
+TEST(MessageLoopPerfTest, WakeupLatency4Threads) {
+  RunWakeupLatencyTest(4);
+}
+
+}  // namespace base
@@ -4,15 +4,15 @@
 
 #include "base/pending_task.h"
 
+#include <algorithm>
+
+#include "base/logging.h"
 #include "base/tracked_objects.h"
 
 namespace base {
 
-#if _MSC_VER >= 1700
-// This a temporary fix for compiling on VS2012. http://crbug.com/154744
 PendingTask::PendingTask() : sequence_num(-1), nestable(false) {
 }
-#endif
 
 PendingTask::PendingTask(const tracked_objects::Location& posted_from,
                          const base::Closure& task)
@@ -53,8 +53,60 @@ bool PendingTask::operator<(const PendingTask& other) const {
   return (sequence_num - other.sequence_num) > 0;
 }
 
+void PendingTask::Swap(PendingTask* other) {
+  std::swap(birth_tally, other->birth_tally);
+  std::swap(time_posted, other->time_posted);
+  std::swap(delayed_run_time, other->delayed_run_time);
+  task.Swap(&other->task);
+  std::swap(posted_from, other->posted_from);
+  std::swap(sequence_num, other->sequence_num);
+  std::swap(nestable, other->nestable);
+}
+
 void TaskQueue::Swap(TaskQueue* queue) {
   c.swap(queue->c);  // Calls std::deque::swap.
 }
 
+void TaskQueue::PushBySwap(PendingTask* task) {
+  c.push_back(PendingTask());
+  c.back().Swap(task);
+}
+
+void DelayedTaskQueue::PushBySwap(PendingTask* task) {
+  c.push_back(PendingTask());
+  c.back().Swap(task);
+  // Sift the new task up, keeping the heap layout std::push_heap() expects.
+  size_t i = c.size() - 1;
+  while (i > 0) {
+    size_t parent = (i - 1) / 2;
+    if (!comp(c[parent], c[i]))
+      break;
+    c[parent].Swap(&c[i]);
+    i = parent;
+  }
+}
+
+void DelayedTaskQueue::PopBySwap(PendingTask* task) {
+  DCHECK(!c.empty());
+  task->Swap(&c.front());
+  c.front().Swap(&c.back());
+  c.pop_back();
+  // Sift the former last task down from the top.
+  size_t size = c.size();
+  size_t i = 0;
+  for (;;) {
+    size_t largest = i;
+    size_t left = 2 * i + 1;
+    size_t right = left + 1;
+    if (left < size && comp(c[largest], c[left]))
+      largest = left;
+    if (right < size && comp(c[largest], c[right]))
+      largest = right;
+    if (largest == i)
+      break;
+    c[i].Swap(&c[largest]);
+    i = largest;
+  }
+}
+
 }  // namespace base
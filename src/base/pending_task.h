@@ -18,9 +18,7 @@ namespace base {
 // Contains data about a pending task. Stored in TaskQueue and DelayedTaskQueue
 // for use by classes that queue and execute tasks.
 struct BASE_EXPORT PendingTask : public TrackingInfo {
-#if _MSC_VER >= 1700
   PendingTask();
-#endif
   PendingTask(const tracked_objects::Location& posted_from,
               const Closure& task);
   PendingTask(const tracked_objects::Location& posted_from,
@@ -32,6 +30,10 @@ struct BASE_EXPORT PendingTask : public TrackingInfo {
   // Used to support sorting.
   bool operator<(const PendingTask& other) const;
 
+  // Exchanges the contents of |this| and |other|. Tasks are handed between
+  // queues this way so that the Closure is not copied (and re-referenced).
+  void Swap(PendingTask* other);
+
   // The task to run.
   Closure task;
 
@@ -50,10 +52,25 @@ struct BASE_EXPORT PendingTask : public TrackingInfo {
 class BASE_EXPORT TaskQueue : public std::queue<PendingTask> {
  public:
   void Swap(TaskQueue* queue);
+
+  // Appends |*task| without copying its Closure. |*task| is left empty.
+  void PushBySwap(PendingTask* task);
 };
 
 // PendingTasks are sorted by their |delayed_run_time| property.
-typedef std::priority_queue<base::PendingTask> DelayedTaskQueue;
+//
+// push() and pop() copy tasks, and so their Closures, while they restore the
+// heap. The BySwap methods move tasks in, out and around the heap by swapping
+// instead. Both kinds of methods may be mixed.
+class BASE_EXPORT DelayedTaskQueue : public std::priority_queue<PendingTask> {
+ public:
+  // Adds |*task|. |*task| is left empty.
+  void PushBySwap(PendingTask* task);
+
+  // Removes the top task and stores it in |*task|, destroying whatever
+  // |*task| held before.
+  void PopBySwap(PendingTask* task);
+};
 
 }  // namespace base
 
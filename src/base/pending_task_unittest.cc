@@ -0,0 +1,61 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/pending_task.h"
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace {
+
+void DoNothing(int id) {
+}
+
+PendingTask MakeTask(int64 delay_ms, int sequence_num) {
+  PendingTask task(FROM_HERE, Bind(&DoNothing, sequence_num),
+                   TimeTicks() + TimeDelta::FromMilliseconds(delay_ms), true);
+  task.sequence_num = sequence_num;
+  return task;
+}
+
+TEST(DelayedTaskQueueTest, SwapKeepsOrder) {
+  // Delays are out of order and repeat; ties are broken by sequence number.
+  const int64 kDelays[] = { 50, 10, 30, 10, 70, 20, 30, 0, 60, 10 };
+
+  DelayedTaskQueue queue;
+  for (size_t i = 0; i < arraysize(kDelays); ++i) {
+    PendingTask task = MakeTask(kDelays[i], static_cast<int>(i));
+    // Mix both ways of adding tasks.
+    if (i % 2) {
+      queue.PushBySwap(&task);
+      EXPECT_TRUE(task.task.is_null());
+    } else {
+      queue.push(task);
+    }
+  }
+
+  PendingTask previous;
+  for (size_t i = 0; i < arraysize(kDelays); ++i) {
+    PendingTask task;
+    if (i % 3) {
+      queue.PopBySwap(&task);
+    } else {
+      task = queue.top();
+      queue.pop();
+    }
+    EXPECT_FALSE(task.task.is_null());
+    if (i > 0) {
+      EXPECT_LE(previous.delayed_run_time, task.delayed_run_time);
+      if (previous.delayed_run_time == task.delayed_run_time)
+        EXPECT_LT(previous.sequence_num, task.sequence_num);
+    }
+    previous = task;
+  }
+  EXPECT_TRUE(queue.empty());
+}
+
+}  // namespace
+}  // namespace base
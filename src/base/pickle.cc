@@ -13,11 +13,21 @@
 // static
 const int Pickle::kPayloadUnit = 64;
 
+// Below this size a gather write costs more than the copy it saves.
+// static
+const int Pickle::kMinDataReferenceSize = 4096;
+
 static const size_t kCapacityReadOnly = static_cast<size_t>(-1);
 
+// Pads referenced data to uint32 alignment.
+static const char kPadding[sizeof(uint32)] = { 0 };
+
 PickleIterator::PickleIterator(const Pickle& pickle)
     : read_ptr_(pickle.payload()),
       read_end_ptr_(pickle.end_of_payload()) {
+  // Referenced data is not in the buffer, so reads stop there.
+  if (pickle.has_data_references())
+    read_end_ptr_ = read_ptr_ + pickle.references_[0].offset;
 }
 
 template <typename Type>
@@ -130,6 +140,38 @@ bool PickleIterator::ReadString16(string16* result) {
   return true;
 }
 
+bool PickleIterator::ReadStringPiece(base::StringPiece* result) {
+  int len;
+  if (!ReadInt(&len))
+    return false;
+  const char* read_from = GetReadPointerAndAdvance(len);
+  if (!read_from)
+    return false;
+
+  result->set(read_from, len);
+  return true;
+}
+
+bool PickleIterator::ReadStringPiece16(base::StringPiece16* result) {
+  int len;
+  if (!ReadInt(&len))
+    return false;
+  const char* read_from = GetReadPointerAndAdvance(len, sizeof(char16));
+  if (!read_from)
+    return false;
+
+  result->set(reinterpret_cast<const char16*>(read_from), len);
+  return true;
+}
+
+bool PickleIterator::ReadBytesView(base::StringPiece* result, int length) {
+  const char* read_from = GetReadPointerAndAdvance(length);
+  if (!read_from)
+    return false;
+  result->set(read_from, length);
+  return true;
+}
+
 bool PickleIterator::ReadData(const char** data, int* length) {
   *length = 0;
   *data = 0;
@@ -154,7 +196,8 @@ Pickle::Pickle()
     : header_(NULL),
       header_size_(sizeof(Header)),
       capacity_(0),
-      variable_buffer_offset_(0) {
+      variable_buffer_offset_(0),
+      references_size_(0) {
   Resize(kPayloadUnit);
   header_->payload_size = 0;
 }
@@ -163,7 +206,8 @@ Pickle::Pickle(int header_size)
     : header_(NULL),
       header_size_(AlignInt(header_size, sizeof(uint32))),
       capacity_(0),
-      variable_buffer_offset_(0) {
+      variable_buffer_offset_(0),
+      references_size_(0) {
   DCHECK_GE(static_cast<size_t>(header_size), sizeof(Header));
   DCHECK_LE(header_size, kPayloadUnit);
   Resize(kPayloadUnit);
@@ -174,7 +218,8 @@ Pickle::Pickle(const char* data, int data_len)
     : header_(reinterpret_cast<Header*>(const_cast<char*>(data))),
       header_size_(0),
       capacity_(kCapacityReadOnly),
-      variable_buffer_offset_(0) {
+      variable_buffer_offset_(0),
+      references_size_(0) {
   if (data_len >= static_cast<int>(sizeof(Header)))
     header_size_ = data_len - header_->payload_size;
 
@@ -193,11 +238,11 @@ Pickle::Pickle(const Pickle& other)
     : header_(NULL),
       header_size_(other.header_size_),
       capacity_(0),
-      variable_buffer_offset_(other.variable_buffer_offset_) {
-  size_t payload_size = header_size_ + other.header_->payload_size;
-  bool resized = Resize(payload_size);
+      variable_buffer_offset_(other.variable_buffer_offset_),
+      references_size_(0) {
+  bool resized = Resize(other.size());
   CHECK(resized);  // Realloc failed.
-  memcpy(header_, other.header_, payload_size);
+  other.CopyFlattenedTo(reinterpret_cast<char*>(header_));
 }
 
 Pickle::~Pickle() {
@@ -219,11 +264,12 @@ Pickle& Pickle::operator=(const Pickle& other) {
     header_ = NULL;
     header_size_ = other.header_size_;
   }
-  bool resized = Resize(other.header_size_ + other.header_->payload_size);
+  bool resized = Resize(other.size());
   CHECK(resized);  // Realloc failed.
-  memcpy(header_, other.header_,
-         other.header_size_ + other.header_->payload_size);
+  other.CopyFlattenedTo(reinterpret_cast<char*>(header_));
   variable_buffer_offset_ = other.variable_buffer_offset_;
+  references_.clear();
+  references_size_ = 0;
   return *this;
 }
 
@@ -270,6 +316,8 @@ bool Pickle::WriteBytes(const void* data, int data_len) {
 char* Pickle::BeginWriteData(int length) {
   DCHECK_EQ(variable_buffer_offset_, 0U) <<
     "There can only be one variable buffer in a Pickle";
+  DCHECK(!has_data_references()) <<
+    "A variable buffer can not be combined with data references";
 
   if (length < 0 || !WriteInt(length))
     return NULL;
@@ -304,12 +352,97 @@ void Pickle::TrimWriteData(int new_length) {
   *cur_length = new_length;
 }
 
+bool Pickle::WriteDataReference(
+    const scoped_refptr<base::RefCountedMemory>& data) {
+  if (data->size() > static_cast<size_t>(kint32max))
+    return false;
+  int length = static_cast<int>(data->size());
+  if (length < kMinDataReferenceSize)
+    return WriteData(reinterpret_cast<const char*>(data->front()), length);
+
+  DCHECK_NE(kCapacityReadOnly, capacity_) << "oops: pickle is readonly";
+  DCHECK_EQ(variable_buffer_offset_, 0U) <<
+    "A variable buffer can not be combined with data references";
+  // Check for overflow before anything is written, so that a failed call
+  // leaves the Pickle unchanged.
+  uint64 new_payload_size =
+      static_cast<uint64>(AlignInt(header_->payload_size, sizeof(uint32))) +
+      sizeof(int) + AlignInt(length, sizeof(uint32));
+  if (new_payload_size > kuint32max || !WriteInt(length))
+    return false;
+
+  size_t padded_length = AlignInt(length, sizeof(uint32));
+  DataReference reference;
+  reference.offset = header_->payload_size - references_size_;
+  reference.data = data;
+  references_.push_back(reference);
+  references_size_ += padded_length;
+  header_->payload_size += static_cast<uint32>(padded_length);
+  return true;
+}
+
+void Pickle::GetSegments(std::vector<Segment>* segments) const {
+  const char* buffer = reinterpret_cast<const char*>(header_);
+  size_t buffer_offset = 0;
+  for (size_t i = 0; i < references_.size(); ++i) {
+    const DataReference& reference = references_[i];
+    // The length of the blob always precedes it in the buffer, so the
+    // buffered segment is never empty.
+    Segment buffered = { buffer + buffer_offset,
+                         header_size_ + reference.offset - buffer_offset };
+    segments->push_back(buffered);
+    size_t size = reference.data->size();
+    Segment referenced = {
+      reinterpret_cast<const char*>(reference.data->front()), size };
+    segments->push_back(referenced);
+    if (size % sizeof(uint32)) {
+      Segment padding = { kPadding, sizeof(uint32) - size % sizeof(uint32) };
+      segments->push_back(padding);
+    }
+    buffer_offset = header_size_ + reference.offset;
+  }
+  size_t buffer_size = size() - references_size_;
+  if (buffer_offset < buffer_size) {
+    Segment buffered = { buffer + buffer_offset, buffer_size - buffer_offset };
+    segments->push_back(buffered);
+  }
+}
+
+void Pickle::Flatten() {
+  if (!has_data_references())
+    return;
+
+  size_t new_capacity = AlignInt(size(), kPayloadUnit);
+  char* flat = static_cast<char*>(malloc(new_capacity));
+  CHECK(flat);  // Malloc failed.
+  CopyFlattenedTo(flat);
+  free(header_);
+  header_ = reinterpret_cast<Header*>(flat);
+  capacity_ = new_capacity;
+  references_.clear();
+  references_size_ = 0;
+}
+
+void Pickle::CopyFlattenedTo(char* dest) const {
+  if (!has_data_references()) {
+    memcpy(dest, header_, size());
+    return;
+  }
+  std::vector<Segment> segments;
+  GetSegments(&segments);
+  for (size_t i = 0; i < segments.size(); ++i) {
+    memcpy(dest, segments[i].data, segments[i].size);
+    dest += segments[i].size;
+  }
+}
+
 char* Pickle::BeginWrite(size_t length) {
   // write at a uint32-aligned offset from the beginning of the header
   size_t offset = AlignInt(header_->payload_size, sizeof(uint32));
 
   size_t new_size = offset + length;
-  size_t needed_size = header_size_ + new_size;
+  // Referenced data takes no space in the buffer.
+  size_t needed_size = header_size_ + new_size - references_size_;
   if (needed_size > capacity_ && !Resize(std::max(capacity_ * 2, needed_size)))
     return NULL;
 
@@ -318,7 +451,7 @@ char* Pickle::BeginWrite(size_t length) {
 #endif
 
   header_->payload_size = static_cast<uint32>(new_size);
-  return mutable_payload() + offset;
+  return mutable_payload() + offset - references_size_;
 }
 
 void Pickle::EndWrite(char* dest, int length) {
@@ -6,13 +6,17 @@
 #define BASE_PICKLE_H__
 
 #include <string>
+#include <vector>
 
 #include "base/base_export.h"
 #include "base/basictypes.h"
 #include "base/compiler_specific.h"
 #include "base/gtest_prod_util.h"
 #include "base/logging.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/ref_counted_memory.h"
 #include "base/strings/string16.h"
+#include "base/strings/string_piece.h"
 
 class Pickle;
 
@@ -41,6 +45,15 @@ class BASE_EXPORT PickleIterator {
   bool ReadData(const char** data, int* length) WARN_UNUSED_RESULT;
   bool ReadBytes(const char** data, int length) WARN_UNUSED_RESULT;
 
+  // Like ReadString() and ReadString16(), but return a view into the Pickle's
+  // buffer instead of copying. The view is only valid as long as the Pickle's
+  // data. ReadStringPiece() can also read blobs written with WriteData().
+  bool ReadStringPiece(base::StringPiece* result) WARN_UNUSED_RESULT;
+  bool ReadStringPiece16(base::StringPiece16* result) WARN_UNUSED_RESULT;
+
+  // Like ReadBytes(), but returns the |length| bytes as a view.
+  bool ReadBytesView(base::StringPiece* result, int length) WARN_UNUSED_RESULT;
+
   // Safer version of ReadInt() checks for the result not being negative.
   // Use it for reading the object sizes.
   bool ReadLength(int* result) WARN_UNUSED_RESULT {
@@ -132,8 +145,12 @@ class BASE_EXPORT Pickle {
   // Returns the size of the Pickle's data.
   size_t size() const { return header_size_ + header_->payload_size; }
 
-  // Returns the data for this Pickle.
-  const void* data() const { return header_; }
+  // Returns the data for this Pickle. A Pickle holding data references must
+  // be flattened first, see WriteDataReference().
+  const void* data() const {
+    DCHECK(!has_data_references()) << "Pickle must be flattened first";
+    return header_;
+  }
 
   // For compatibility, these older style read methods pass through to the
   // PickleIterator methods.
@@ -257,6 +274,34 @@ class BASE_EXPORT Pickle {
   // not been changed.
   void TrimWriteData(int length);
 
+  // Same as WriteData, but a large blob is not copied into the Pickle: the
+  // Pickle keeps a reference to |data| until it is flattened or destroyed,
+  // so the blob can be written out long after this call returns. The
+  // contents of |data| must not change in the meantime. Small blobs are
+  // copied. The serialized form is identical to WriteData's, so the reader
+  // uses ReadData or ReadStringPiece.
+  //
+  // A Pickle holding references has no contiguous data(). Write it out with
+  // GetSegments(), or call Flatten() first. A PickleIterator over such a
+  // Pickle stops at the first reference.
+  bool WriteDataReference(const scoped_refptr<base::RefCountedMemory>& data);
+
+  bool has_data_references() const { return !references_.empty(); }
+
+  // A contiguous piece of the serialized Pickle. See GetSegments().
+  struct Segment {
+    const char* data;
+    size_t size;
+  };
+
+  // Appends the serialized Pickle, header included, to |segments| as a list
+  // of pieces suitable for a gather write such as writev(). Without data
+  // references this is the single segment {data(), size()}.
+  void GetSegments(std::vector<Segment>* segments) const;
+
+  // Copies all referenced data into the Pickle's own buffer.
+  void Flatten();
+
   // Payload follows after allocation of Header (header size is customizable).
   struct Header {
     uint32 payload_size;  // Specifies the size of the payload.
@@ -284,10 +329,11 @@ class BASE_EXPORT Pickle {
   }
 
   // Returns the address of the byte immediately following the currently valid
-  // header + payload.
+  // header + payload. If the Pickle holds data references, this is the end of
+  // the part of the payload held in the Pickle's own buffer.
   const char* end_of_payload() const {
     // This object may be invalid.
-    return header_ ? payload() + payload_size() : NULL;
+    return header_ ? payload() + payload_size() - references_size_ : NULL;
   }
 
  protected:
@@ -330,18 +376,38 @@ class BASE_EXPORT Pickle {
   // The allocation granularity of the payload.
   static const int kPayloadUnit;
 
+  // Blobs smaller than this are copied by WriteDataReference.
+  static const int kMinDataReferenceSize;
+
  private:
   friend class PickleIterator;
 
+  // A blob written with WriteDataReference. It logically follows the first
+  // |offset| bytes of the payload stored in the buffer.
+  struct DataReference {
+    size_t offset;
+    scoped_refptr<base::RefCountedMemory> data;
+  };
+
+  // Copies the serialized Pickle, including referenced data, to |dest|,
+  // which must hold size() bytes.
+  void CopyFlattenedTo(char* dest) const;
+
   Header* header_;
   size_t header_size_;  // Supports extra data between header and payload.
   // Allocation size of payload (or -1 if allocation is const).
   size_t capacity_;
   size_t variable_buffer_offset_;  // IF non-zero, then offset to a buffer.
+  std::vector<DataReference> references_;
+  // The part of payload_size, padding included, that is held in references_
+  // rather than in the buffer.
+  size_t references_size_;
 
   FRIEND_TEST_ALL_PREFIXES(PickleTest, Resize);
   FRIEND_TEST_ALL_PREFIXES(PickleTest, FindNext);
   FRIEND_TEST_ALL_PREFIXES(PickleTest, FindNextWithIncompleteHeader);
+  FRIEND_TEST_ALL_PREFIXES(PickleTest, DataReferences);
+  FRIEND_TEST_ALL_PREFIXES(PickleTest, DataReferencesDoNotGrowBuffer);
 };
 
 #endif  // BASE_PICKLE_H__
@@ -8,6 +8,7 @@
 #include "base/memory/scoped_ptr.h"
 #include "base/pickle.h"
 #include "base/strings/string16.h"
+#include "base/strings/utf_string_conversions.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace {
@@ -66,6 +67,12 @@ void VerifyResult(const Pickle& pickle) {
   EXPECT_FALSE(pickle.ReadInt(&iter, &outint));
 }
 
+// Returns a reference counted copy of |str| for WriteDataReference().
+scoped_refptr<base::RefCountedMemory> MakeBlob(const std::string& str) {
+  std::string copy(str);
+  return base::RefCountedString::TakeString(&copy);
+}
+
 }  // namespace
 
 TEST(PickleTest, EncodeDecode) {
@@ -340,3 +347,136 @@ TEST(PickleTest, ReadBytes) {
   memcpy(&outdata, outdata_char, sizeof(outdata));
   EXPECT_EQ(data, outdata);
 }
+
+TEST(PickleTest, ReadStringPiece) {
+  Pickle pickle;
+  EXPECT_TRUE(pickle.WriteString(teststr));
+  EXPECT_TRUE(pickle.WriteString16(ASCIIToUTF16(teststr)));
+  EXPECT_TRUE(pickle.WriteData(testdata, testdatalen));
+  EXPECT_TRUE(pickle.WriteInt(-1));
+
+  PickleIterator iter(pickle);
+  base::StringPiece piece;
+  EXPECT_TRUE(iter.ReadStringPiece(&piece));
+  EXPECT_EQ(teststr, piece.as_string());
+  // The result points into the pickle.
+  EXPECT_GE(piece.data(), pickle.payload());
+  EXPECT_LE(piece.data() + piece.size(), pickle.end_of_payload());
+  base::StringPiece16 piece16;
+  EXPECT_TRUE(iter.ReadStringPiece16(&piece16));
+  EXPECT_EQ(ASCIIToUTF16(teststr), piece16.as_string());
+  EXPECT_TRUE(iter.ReadStringPiece(&piece));
+  EXPECT_EQ(std::string(testdata, testdatalen), piece.as_string());
+  // A negative length is rejected.
+  EXPECT_FALSE(iter.ReadStringPiece(&piece));
+}
+
+TEST(PickleTest, ReadBytesView) {
+  Pickle pickle;
+  EXPECT_TRUE(pickle.WriteBytes(testdata, testdatalen));
+  EXPECT_TRUE(pickle.WriteInt(testint));
+
+  PickleIterator iter(pickle);
+  base::StringPiece piece;
+  EXPECT_TRUE(iter.ReadBytesView(&piece, testdatalen));
+  EXPECT_EQ(std::string(testdata, testdatalen), piece.as_string());
+  EXPECT_EQ(pickle.payload(), piece.data());
+  EXPECT_FALSE(iter.ReadBytesView(&piece, -1));
+  EXPECT_FALSE(iter.ReadBytesView(&piece, sizeof(int) + 1));
+  int outint;
+  EXPECT_TRUE(iter.ReadInt(&outint));
+  EXPECT_EQ(testint, outint);
+}
+
+TEST(PickleTest, DataReferences) {
+  // Odd sizes so that the references need padding.
+  std::string large1(Pickle::kMinDataReferenceSize + 1, 'a');
+  std::string large2(Pickle::kMinDataReferenceSize * 3 + 2, 'b');
+  large2[0] = 'c';
+
+  scoped_refptr<base::RefCountedMemory> blob1 = MakeBlob(large1);
+  const char* blob1_data = reinterpret_cast<const char*>(blob1->front());
+
+  Pickle pickle;
+  EXPECT_TRUE(pickle.WriteInt(testint));
+  EXPECT_TRUE(pickle.WriteDataReference(blob1));
+  EXPECT_TRUE(pickle.WriteDataReference(MakeBlob(large2)));
+  EXPECT_TRUE(pickle.WriteString(teststr));
+  // Small blobs are copied.
+  EXPECT_TRUE(pickle.WriteDataReference(
+      MakeBlob(std::string(testdata, testdatalen))));
+  EXPECT_EQ(2u, pickle.references_.size());
+  // The pickle keeps the referenced data alive.
+  EXPECT_FALSE(blob1->HasOneRef());
+  blob1 = NULL;
+  EXPECT_TRUE(pickle.has_data_references());
+
+  // The same data written with WriteData serializes identically.
+  Pickle expected;
+  EXPECT_TRUE(expected.WriteInt(testint));
+  EXPECT_TRUE(expected.WriteData(large1.data(), large1.size()));
+  EXPECT_TRUE(expected.WriteData(large2.data(), large2.size()));
+  EXPECT_TRUE(expected.WriteString(teststr));
+  EXPECT_TRUE(expected.WriteData(testdata, testdatalen));
+  ASSERT_EQ(expected.size(), pickle.size());
+
+  std::vector<Pickle::Segment> segments;
+  pickle.GetSegments(&segments);
+  std::string gathered;
+  for (size_t i = 0; i < segments.size(); ++i)
+    gathered.append(segments[i].data, segments[i].size);
+  EXPECT_EQ(std::string(static_cast<const char*>(expected.data()),
+                        expected.size()), gathered);
+  // The referenced data is not copied.
+  EXPECT_EQ(blob1_data, segments[1].data);
+  // end_of_payload() is the end of the data held in the pickle's buffer.
+  EXPECT_EQ(pickle.end_of_payload(),
+            segments.back().data + segments.back().size);
+
+  // Reading stops at the first reference until the pickle is flattened.
+  PickleIterator iter(pickle);
+  int outint;
+  const char* outdata;
+  int outdatalen;
+  EXPECT_TRUE(iter.ReadInt(&outint));
+  EXPECT_FALSE(iter.ReadData(&outdata, &outdatalen));
+
+  // Copies are flat.
+  Pickle copy(pickle);
+  EXPECT_FALSE(copy.has_data_references());
+  EXPECT_EQ(gathered, std::string(static_cast<const char*>(copy.data()),
+                                  copy.size()));
+
+  pickle.Flatten();
+  EXPECT_FALSE(pickle.has_data_references());
+  EXPECT_EQ(gathered, std::string(static_cast<const char*>(pickle.data()),
+                                  pickle.size()));
+  // Later writes go after the flattened data.
+  EXPECT_TRUE(pickle.WriteInt(testint));
+  PickleIterator flat_iter(pickle);
+  base::StringPiece piece;
+  EXPECT_TRUE(flat_iter.ReadInt(&outint));
+  EXPECT_TRUE(flat_iter.ReadStringPiece(&piece));
+  EXPECT_EQ(large1, piece.as_string());
+  EXPECT_TRUE(flat_iter.ReadStringPiece(&piece));
+  EXPECT_EQ(large2, piece.as_string());
+  EXPECT_TRUE(flat_iter.ReadStringPiece(&piece));
+  EXPECT_EQ(teststr, piece.as_string());
+  EXPECT_TRUE(flat_iter.ReadStringPiece(&piece));
+  EXPECT_EQ(std::string(testdata, testdatalen), piece.as_string());
+  EXPECT_TRUE(flat_iter.ReadInt(&outint));
+  EXPECT_EQ(testint, outint);
+  EXPECT_FALSE(flat_iter.ReadInt(&outint));
+}
+
+// Writes after a reference must not grow the buffer by the referenced size.
+TEST(PickleTest, DataReferencesDoNotGrowBuffer) {
+  std::string large(1024 * 1024, 'x');
+  Pickle pickle;
+  EXPECT_TRUE(pickle.WriteDataReference(MakeBlob(large)));
+  EXPECT_TRUE(pickle.WriteString(teststr));
+  EXPECT_LT(pickle.capacity(), large.size());
+  EXPECT_EQ(sizeof(Pickle::Header) + sizeof(int) + large.size() +
+                sizeof(int) + teststr.size(),
+            pickle.size());
+}
@@ -52,6 +52,7 @@
         'ipc_message_unittest.cc',
         'ipc_message_utils_unittest.cc',
         'ipc_send_fds_test.cc',
+        'ipc_shared_memory_ring_unittest.cc',
         'ipc_sync_channel_unittest.cc',
         'ipc_sync_message_unittest.cc',
         'ipc_sync_message_unittest.h',
@@ -68,6 +69,7 @@
         }],
         ['OS == "win" or OS == "ios"', {
           'sources!': [
+            'ipc_shared_memory_ring_unittest.cc',
             'unix_domain_socket_util_unittest.cc',
           ],
         }],
@@ -79,18 +79,26 @@ class IPC_EXPORT Channel : public Sender {
   // by the peer when the channel is connected.  The message contains
   // just the process id (pid).  The message has a special routing_id
   // (MSG_ROUTING_NONE) and type (HELLO_MESSAGE_TYPE).
+  //
+  // The SharedMemory message is also internal. A POSIX channel sends it when
+  // both peers offered the shared memory transport in their Hello messages;
+  // it carries the ring that all of the sender's later messages are written
+  // to (see ipc_channel_posix.h).
   enum {
-    HELLO_MESSAGE_TYPE = kuint16max  // Maximum value of message type (uint16),
-                                     // to avoid conflicting with normal
-                                     // message types, which are enumeration
-                                     // constants starting from 0.
+    HELLO_MESSAGE_TYPE = kuint16max,  // Maximum value of message type (uint16),
+                                      // to avoid conflicting with normal
+                                      // message types, which are enumeration
+                                      // constants starting from 0.
+    SHARED_MEMORY_MESSAGE_TYPE = kuint16max - 1
   };
 
   // The maximum message size in bytes. Attempting to receive a message of this
   // size or bigger results in a channel error.
   static const size_t kMaximumMessageSize = 128 * 1024 * 1024;
 
-  // Amount of data to read at once from the pipe.
+  // Amount of data to read at once from the pipe when the read may also carry
+  // file descriptors. Other reads use a larger buffer so that a burst of
+  // small messages is taken in with one system call.
   static const size_t kReadBufferSize = 4 * 1024;
 
   // Initialize a Channel.
@@ -173,6 +181,16 @@ class IPC_EXPORT Channel : public Sender {
   // Closes any currently connected socket, and returns to a listening state
   // for more connections.
   void ResetToAcceptingConnectionState();
+
+  // Counts of the messages this channel has sent and received, and of the
+  // write and read calls that carried them. Used by performance tests.
+  struct IOStatistics {
+    size_t messages_sent;
+    size_t write_calls;
+    size_t messages_received;
+    size_t read_calls;
+  };
+  IOStatistics GetIOStatistics() const;
 #endif  // defined(OS_POSIX) && !defined(OS_NACL)
 
   // Returns true if a named server channel is initialized on the given channel
@@ -6,19 +6,19 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <stddef.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
 
-#if defined(OS_OPENBSD)
-#include <sys/uio.h>
-#endif
-
+#include <algorithm>
 #include <map>
 #include <string>
+#include <vector>
 
 #include "base/command_line.h"
 #include "base/file_util.h"
@@ -158,6 +158,42 @@ bool SocketWriteErrorIsRecoverable() {
 #endif  // OS_MACOSX
 }
 
+#if defined(IPC_USES_SHARED_MEMORY_RING)
+// Room for a few of the largest common messages without making every channel
+// expensive; larger messages stream through the ring.
+const size_t kSharedMemoryRingCapacity = 256 * 1024;
+#endif
+
+// The most messages WriteBatch() writes with one system call.
+const size_t kMaxMessagesPerWrite = 64;
+
+// Fills |iov| with the part of |message| that follows its first |offset|
+// bytes, gathered from the buffers that make up the message (see
+// Pickle::WriteDataReference()). Returns the number of bytes covered, which
+// is less than the rest of the message if it needs more than IOV_MAX buffers.
+size_t GatherUnsentSegments(const Message& message,
+                            size_t offset,
+                            std::vector<struct iovec>* iov) {
+  std::vector<Pickle::Segment> segments;
+  message.GetSegments(&segments);
+  size_t covered = 0;
+  for (size_t i = 0; i < segments.size() &&
+       iov->size() < static_cast<size_t>(IOV_MAX); ++i) {
+    if (offset >= segments[i].size) {
+      offset -= segments[i].size;
+      continue;
+    }
+    struct iovec segment = {
+      const_cast<char*>(segments[i].data) + offset,
+      segments[i].size - offset
+    };
+    iov->push_back(segment);
+    covered += segment.iov_len;
+    offset = 0;
+  }
+  return covered;
+}
+
 }  // namespace
 //------------------------------------------------------------------------------
 
@@ -173,6 +209,8 @@ Channel::ChannelImpl::ChannelImpl(const IPC::ChannelHandle& channel_handle,
       is_blocked_on_write_(false),
       waiting_connect_(true),
       message_send_bytes_written_(0),
+      messages_sent_(0),
+      write_calls_(0),
       server_listen_pipe_(-1),
       pipe_(-1),
       client_pipe_(-1),
@@ -180,6 +218,13 @@ Channel::ChannelImpl::ChannelImpl(const IPC::ChannelHandle& channel_handle,
       fd_pipe_(-1),
       remote_fd_pipe_(-1),
 #endif  // IPC_USES_READWRITE
+#if defined(IPC_USES_SHARED_MEMORY_RING)
+      offer_shared_memory_(CommandLine::ForCurrentProcess()->HasSwitch(
+          switches::kIPCSharedMemoryTransport)),
+      shared_memory_message_(NULL),
+      writing_to_ring_(false),
+      peer_closed_pipe_(false),
+#endif  // IPC_USES_SHARED_MEMORY_RING
       pipe_name_(channel_handle.name),
       must_unlink_(false) {
   memset(input_cmsg_buf_, 0, sizeof(input_cmsg_buf_));
@@ -359,17 +404,40 @@ bool Channel::ChannelImpl::ProcessOutgoingMessages() {
   // Write out all the messages we can till the write blocks or there are no
   // more outgoing messages.
   while (!output_queue_.empty()) {
-    Message* msg = output_queue_.front();
+    // A burst of small messages goes out with a single write.
+    size_t batch_size = CountBatchableMessages();
+    if (batch_size > 1) {
+      bool blocked = false;
+      if (!WriteBatch(batch_size, &blocked))
+        return false;
+      if (blocked)
+        return true;
+      continue;
+    }
 
-    size_t amt_to_write = msg->size() - message_send_bytes_written_;
-    DCHECK_NE(0U, amt_to_write);
-    const char* out_bytes = reinterpret_cast<const char*>(msg->data()) +
-        message_send_bytes_written_;
+    Message* msg = output_queue_.front();
 
     struct msghdr msgh = {0};
-    struct iovec iov = {const_cast<char*>(out_bytes), amt_to_write};
-    msgh.msg_iov = &iov;
-    msgh.msg_iovlen = 1;
+    size_t amt_to_write;
+    struct iovec iov;
+    std::vector<struct iovec> gathered_iov;
+    if (!msg->has_data_references()) {
+      amt_to_write = msg->size() - message_send_bytes_written_;
+      iov.iov_base = const_cast<char*>(
+          reinterpret_cast<const char*>(msg->data()) +
+          message_send_bytes_written_);
+      iov.iov_len = amt_to_write;
+      msgh.msg_iov = &iov;
+      msgh.msg_iovlen = 1;
+    } else {
+      // Large blobs are written from their own buffers without being copied
+      // into the message.
+      amt_to_write = GatherUnsentSegments(*msg, message_send_bytes_written_,
+                                          &gathered_iov);
+      msgh.msg_iov = &gathered_iov[0];
+      msgh.msg_iovlen = gathered_iov.size();
+    }
+    DCHECK_NE(0U, amt_to_write);
     char buf[CMSG_SPACE(
         sizeof(int) * FileDescriptorSet::kMaxDescriptorsPerMessage)];
 
@@ -413,10 +481,15 @@ bool Channel::ChannelImpl::ProcessOutgoingMessages() {
         // Subsequently, we can send file descriptors on the dedicated
         // fd_pipe_ which makes Seccomp sandbox operation more efficient.
         struct iovec fd_pipe_iov = { const_cast<char *>(""), 1 };
+        struct iovec* message_iov = msgh.msg_iov;
+        size_t message_iovlen = msgh.msg_iovlen;
         msgh.msg_iov = &fd_pipe_iov;
+        msgh.msg_iovlen = 1;
         fd_written = fd_pipe_;
+        ++write_calls_;
         bytes_written = HANDLE_EINTR(sendmsg(fd_pipe_, &msgh, MSG_DONTWAIT));
-        msgh.msg_iov = &iov;
+        msgh.msg_iov = message_iov;
+        msgh.msg_iovlen = message_iovlen;
         msgh.msg_controllen = 0;
         if (bytes_written > 0) {
           msg->file_descriptor_set()->CommitAll();
@@ -427,12 +500,19 @@ bool Channel::ChannelImpl::ProcessOutgoingMessages() {
 
     if (bytes_written == 1) {
       fd_written = pipe_;
+      ++write_calls_;
 #if defined(IPC_USES_READWRITE)
       if ((mode_ & MODE_CLIENT_FLAG) && IsHelloMessage(*msg)) {
         DCHECK_EQ(msg->file_descriptor_set()->size(), 1U);
       }
       if (!msgh.msg_controllen) {
-        bytes_written = HANDLE_EINTR(write(pipe_, out_bytes, amt_to_write));
+#if defined(IPC_USES_SHARED_MEMORY_RING)
+        if (writing_to_ring_)
+          bytes_written = WriteToRing(msgh.msg_iov, msgh.msg_iovlen);
+        else
+#endif  // IPC_USES_SHARED_MEMORY_RING
+          bytes_written = HANDLE_EINTR(writev(pipe_, msgh.msg_iov,
+                                              msgh.msg_iovlen));
       } else
 #endif  // IPC_USES_READWRITE
       {
@@ -443,21 +523,7 @@ bool Channel::ChannelImpl::ProcessOutgoingMessages() {
       msg->file_descriptor_set()->CommitAll();
 
     if (bytes_written < 0 && !SocketWriteErrorIsRecoverable()) {
-#if defined(OS_MACOSX)
-      // On OSX writing to a pipe with no listener returns EPERM.
-      if (errno == EPERM) {
-        Close();
-        return false;
-      }
-#endif  // OS_MACOSX
-      if (errno == EPIPE) {
-        Close();
-        return false;
-      }
-      PLOG(ERROR) << "pipe error on "
-                  << fd_written
-                  << " Currently writing message of size: "
-                  << msg->size();
+      HandleWriteError(fd_written, msg->size());
       return false;
     }
 
@@ -467,28 +533,180 @@ bool Channel::ChannelImpl::ProcessOutgoingMessages() {
         message_send_bytes_written_ += bytes_written;
       }
 
-      // Tell libevent to call us back once things are unblocked.
-      is_blocked_on_write_ = true;
-      base::MessageLoopForIO::current()->WatchFileDescriptor(
-          pipe_,
-          false,  // One shot
-          base::MessageLoopForIO::WATCH_WRITE,
-          &write_watcher_,
-          this);
+#if defined(IPC_USES_SHARED_MEMORY_RING)
+      if (writing_to_ring_) {
+        // The ring is full. The peer sends a wakeup over pipe_ once it has
+        // made room, see OnFileCanReadWithoutBlocking().
+        if (output_ring_->WaitForSpace())
+          continue;
+        is_blocked_on_write_ = true;
+        return true;
+      }
+#endif  // IPC_USES_SHARED_MEMORY_RING
+
+      WatchForWrite();
       return true;
+    } else if (message_send_bytes_written_ + bytes_written < msg->size()) {
+      // The message has more segments than fit in one write.
+      message_send_bytes_written_ += bytes_written;
     } else {
       message_send_bytes_written_ = 0;
 
+#if defined(IPC_USES_SHARED_MEMORY_RING)
+      if (msg == shared_memory_message_) {
+        shared_memory_message_ = NULL;
+        writing_to_ring_ = true;
+        DVLOG(1) << "writing to shared memory on channel @" << this;
+        // pipe_ can carry wakeups now; send one the peer asked for earlier.
+        if (input_ring_ && input_ring_->TakeWriterWakeup())
+          SendWakeup();
+      }
+#endif  // IPC_USES_SHARED_MEMORY_RING
+
       // Message sent OK!
       DVLOG(2) << "sent message @" << msg << " on channel @" << this
                << " with type " << msg->type() << " on fd " << pipe_;
+      ++messages_sent_;
       delete output_queue_.front();
-      output_queue_.pop();
+      output_queue_.pop_front();
     }
   }
   return true;
 }
 
+size_t Channel::ChannelImpl::CountBatchableMessages() const {
+  size_t count = 0;
+  while (count < output_queue_.size() && count < kMaxMessagesPerWrite) {
+    const Message* msg = output_queue_[count];
+    if (!msg->file_descriptor_set()->empty())
+      break;
+#if defined(IPC_USES_SHARED_MEMORY_RING)
+    // Whatever follows goes to the ring instead of pipe_.
+    if (msg == shared_memory_message_)
+      break;
+#endif  // IPC_USES_SHARED_MEMORY_RING
+    ++count;
+  }
+  return count;
+}
+
+bool Channel::ChannelImpl::WriteBatch(size_t count, bool* blocked) {
+  std::vector<struct iovec> iov;
+  size_t amt_to_write = 0;
+  for (size_t i = 0; i < count &&
+       iov.size() < static_cast<size_t>(IOV_MAX); ++i) {
+    const Message* msg = output_queue_[i];
+    size_t offset = i == 0 ? message_send_bytes_written_ : 0;
+    size_t unsent = msg->size() - offset;
+    size_t covered;
+    if (!msg->has_data_references()) {
+      struct iovec segment = {
+        const_cast<char*>(static_cast<const char*>(msg->data())) + offset,
+        unsent
+      };
+      iov.push_back(segment);
+      covered = unsent;
+    } else {
+      covered = GatherUnsentSegments(*msg, offset, &iov);
+    }
+    amt_to_write += covered;
+    // Out of iovecs; the rest of the message goes with the next write.
+    if (covered < unsent)
+      break;
+  }
+
+  ssize_t bytes_written;
+  ++write_calls_;
+#if defined(IPC_USES_SHARED_MEMORY_RING)
+  if (writing_to_ring_)
+    bytes_written = WriteToRing(&iov[0], iov.size());
+  else
+#endif  // IPC_USES_SHARED_MEMORY_RING
+#if defined(IPC_USES_READWRITE)
+    bytes_written = HANDLE_EINTR(writev(pipe_, &iov[0], iov.size()));
+#else
+  {
+    struct msghdr msgh = {0};
+    msgh.msg_iov = &iov[0];
+    msgh.msg_iovlen = iov.size();
+    bytes_written = HANDLE_EINTR(sendmsg(pipe_, &msgh, MSG_DONTWAIT));
+  }
+#endif  // IPC_USES_READWRITE
+
+  if (bytes_written < 0) {
+    if (!SocketWriteErrorIsRecoverable()) {
+      HandleWriteError(pipe_, amt_to_write);
+      return false;
+    }
+    bytes_written = 0;
+  }
+
+  // Retire the messages that were sent completely.
+  size_t remaining = bytes_written;
+  while (remaining > 0) {
+    Message* msg = output_queue_.front();
+    size_t unsent = msg->size() - message_send_bytes_written_;
+    if (remaining < unsent) {
+      message_send_bytes_written_ += remaining;
+      break;
+    }
+    remaining -= unsent;
+    message_send_bytes_written_ = 0;
+    DVLOG(2) << "sent message @" << msg << " on channel @" << this
+             << " with type " << msg->type() << " on fd " << pipe_;
+    ++messages_sent_;
+    delete msg;
+    output_queue_.pop_front();
+  }
+
+  if (static_cast<size_t>(bytes_written) == amt_to_write)
+    return true;
+
+#if defined(IPC_USES_SHARED_MEMORY_RING)
+  if (writing_to_ring_) {
+    // See ProcessOutgoingMessages().
+    if (output_ring_->WaitForSpace())
+      return true;
+    is_blocked_on_write_ = true;
+    *blocked = true;
+    return true;
+  }
+#endif  // IPC_USES_SHARED_MEMORY_RING
+
+  WatchForWrite();
+  *blocked = true;
+  return true;
+}
+
+void Channel::ChannelImpl::WatchForWrite() {
+  // Tell libevent to call us back once things are unblocked.
+  is_blocked_on_write_ = true;
+  base::MessageLoopForIO::current()->WatchFileDescriptor(
+      pipe_,
+      false,  // One shot
+      base::MessageLoopForIO::WATCH_WRITE,
+      &write_watcher_,
+      this);
+}
+
+void Channel::ChannelImpl::HandleWriteError(int fd, size_t message_size) {
+#if defined(OS_MACOSX)
+  // On OSX writing to a pipe with no listener returns EPERM.
+  if (errno == EPERM) {
+    Close();
+    return;
+  }
+#endif  // OS_MACOSX
+  if (errno == EPIPE) {
+    Close();
+    return;
+  }
+  PLOG(ERROR) << "pipe error on "
+              << fd
+              << " Currently writing message of size: "
+              << message_size;
+}
+
 bool Channel::ChannelImpl::Send(Message* message) {
   DVLOG(2) << "sending message @" << message << " on channel @" << this
            << " with type " << message->type()
@@ -499,7 +717,7 @@ bool Channel::ChannelImpl::Send(Message* message) {
 #endif  // IPC_MESSAGE_LOG_ENABLED
 
   message->TraceMessageBegin();
-  output_queue_.push(message);
+  output_queue_.push_back(message);
   if (!is_blocked_on_write_ && !waiting_connect_) {
     return ProcessOutgoingMessages();
   }
@@ -545,6 +763,15 @@ bool Channel::ChannelImpl::GetPeerEuid(uid_t* peer_euid) const {
   return IPC::GetPeerEuid(pipe_, peer_euid);
 }
 
+Channel::IOStatistics Channel::ChannelImpl::GetIOStatistics() const {
+  IOStatistics statistics;
+  statistics.messages_sent = messages_sent_;
+  statistics.write_calls = write_calls_;
+  statistics.messages_received = messages_received();
+  statistics.read_calls = read_calls();
+  return statistics;
+}
+
 void Channel::ChannelImpl::ResetToAcceptingConnectionState() {
   // Unregister libevent for the unix domain socket and close it.
   read_watcher_.StopWatchingFileDescriptor();
@@ -569,9 +796,18 @@ void Channel::ChannelImpl::ResetToAcceptingConnectionState() {
 
   while (!output_queue_.empty()) {
     Message* m = output_queue_.front();
-    output_queue_.pop();
+    output_queue_.pop_front();
     delete m;
   }
+  message_send_bytes_written_ = 0;
+
+#if defined(IPC_USES_SHARED_MEMORY_RING)
+  output_ring_.reset();
+  shared_memory_message_ = NULL;
+  writing_to_ring_ = false;
+  input_ring_.reset();
+  peer_closed_pipe_ = false;
+#endif  // IPC_USES_SHARED_MEMORY_RING
 
   // Close any outstanding, received file descriptors.
   ClearInputFDs();
@@ -593,6 +829,7 @@ void Channel::ChannelImpl::SetGlobalPid(int pid) {
 // Called by libevent when we can read from the pipe without blocking.
 void Channel::ChannelImpl::OnFileCanReadWithoutBlocking(int fd) {
   bool send_server_hello_msg = false;
+  bool resume_output = false;
   if (fd == server_listen_pipe_) {
     int new_pipe = 0;
     if (!ServerAcceptConnection(server_listen_pipe_, &new_pipe) ||
@@ -643,6 +880,16 @@ void Channel::ChannelImpl::OnFileCanReadWithoutBlocking(int fd) {
       // ProcessOutgoingMessages.
       send_server_hello_msg = false;
       ClosePipeOnError();
+#if defined(IPC_USES_SHARED_MEMORY_RING)
+    } else if (writing_to_ring_ && is_blocked_on_write_) {
+      // The data may have included a wakeup for a full |output_ring_|.
+      is_blocked_on_write_ = false;
+      resume_output = true;
+    } else if (shared_memory_message_ && !is_blocked_on_write_ &&
+               !waiting_connect_) {
+      // HandleHelloMessage() queued the SHARED_MEMORY message.
+      resume_output = true;
+#endif  // IPC_USES_SHARED_MEMORY_RING
     }
   } else {
     NOTREACHED() << "Unknown pipe " << fd;
@@ -654,6 +901,8 @@ void Channel::ChannelImpl::OnFileCanReadWithoutBlocking(int fd) {
   // is invalid.
   if (send_server_hello_msg) {
     ProcessOutgoingMessages();
+  } else if (resume_output && !ProcessOutgoingMessages()) {
+    ClosePipeOnError();
   }
 }
 
@@ -729,9 +978,104 @@ void Channel::ChannelImpl::QueueHelloMessage() {
     DCHECK_EQ(msg->file_descriptor_set()->size(), 1U);
   }
 #endif  // IPC_USES_READWRITE
-  output_queue_.push(msg.release());
+#if defined(IPC_USES_SHARED_MEMORY_RING)
+  if (offer_shared_memory_) {
+    output_ring_.reset(new internal::SharedMemoryRing);
+    if (!output_ring_->Create(kSharedMemoryRingCapacity)) {
+      LOG(WARNING) << "Unable to create shared memory ring for " << pipe_name_;
+      output_ring_.reset();
+    }
+  }
+  if (!msg->WriteBool(output_ring_ != NULL)) {
+    NOTREACHED() << "Unable to pickle hello message shared memory offer";
+  }
+#endif  // IPC_USES_SHARED_MEMORY_RING
+  output_queue_.push_back(msg.release());
+}
+
+#if defined(IPC_USES_SHARED_MEMORY_RING)
+void Channel::ChannelImpl::QueueSharedMemoryMessage() {
+  DCHECK(output_ring_);
+  scoped_ptr<Message> msg(new Message(MSG_ROUTING_NONE,
+                                      SHARED_MEMORY_MESSAGE_TYPE,
+                                      IPC::Message::PRIORITY_NORMAL));
+  if (!msg->WriteFileDescriptor(
+          base::FileDescriptor(output_ring_->handle().fd, false)) ||
+      !msg->WriteUInt32(static_cast<uint32>(output_ring_->capacity()))) {
+    NOTREACHED() << "Unable to pickle shared memory message";
+  }
+  shared_memory_message_ = msg.get();
+  output_queue_.push_back(msg.release());
 }
 
+ssize_t Channel::ChannelImpl::WriteToRing(const struct iovec* iov,
+                                          size_t iovlen) {
+  size_t total = 0;
+  for (size_t i = 0; i < iovlen; ++i) {
+    size_t written = 0;
+    if (!output_ring_->Write(static_cast<const char*>(iov[i].iov_base),
+                             iov[i].iov_len, &written)) {
+      LOG(ERROR) << "Shared memory ring broken on " << pipe_name_;
+      errno = EPIPE;
+      return -1;
+    }
+    total += written;
+    if (written < iov[i].iov_len)
+      break;
+  }
+  if (total && output_ring_->TakeReaderWakeup())
+    SendWakeup();
+  return total;
+}
+
+Channel::ChannelImpl::ReadState Channel::ChannelImpl::ReadDataFromRing(
+    char* buffer,
+    int buffer_len,
+    int* bytes_read) {
+  size_t count = 0;
+  if (!input_ring_->Read(buffer, buffer_len, &count)) {
+    LOG(ERROR) << "Shared memory ring broken on " << pipe_name_;
+    return READ_FAILED;
+  }
+  if (count == 0 && !peer_closed_pipe_) {
+    // Drain the wakeups before asking for another one, so that a wakeup sent
+    // after the request still makes pipe_ readable.
+    char wakeups[64];
+    ssize_t drained = HANDLE_EINTR(read(pipe_, wakeups, sizeof(wakeups)));
+    if (drained == 0 ||
+        (drained < 0 && (errno == ECONNRESET || errno == EPIPE))) {
+      peer_closed_pipe_ = true;
+    } else if (drained < 0 && errno != EAGAIN) {
+      PLOG(ERROR) << "pipe error (" << pipe_ << ")";
+      return READ_FAILED;
+    }
+    if ((peer_closed_pipe_ || input_ring_->WaitForData()) &&
+        !input_ring_->Read(buffer, buffer_len, &count)) {
+      LOG(ERROR) << "Shared memory ring broken on " << pipe_name_;
+      return READ_FAILED;
+    }
+  }
+  if (count == 0)
+    return peer_closed_pipe_ ? READ_FAILED : READ_PENDING;
+
+  // Wakeups can only be sent once pipe_ no longer carries messages.
+  if (writing_to_ring_ && input_ring_->TakeWriterWakeup())
+    SendWakeup();
+  *bytes_read = static_cast<int>(count);
+  return READ_SUCCEEDED;
+}
+
+void Channel::ChannelImpl::SendWakeup() {
+  // The content does not matter. If the socket is full, the peer has wakeups
+  // to read already.
+  const char kWakeup = 0;
+  if (HANDLE_EINTR(write(pipe_, &kWakeup, 1)) < 0 && errno != EAGAIN &&
+      errno != EPIPE) {
+    DPLOG(ERROR) << "wakeup on " << pipe_name_;
+  }
+}
+#endif  // IPC_USES_SHARED_MEMORY_RING
+
 Channel::ChannelImpl::ReadState Channel::ChannelImpl::ReadData(
     char* buffer,
     int buffer_len,
@@ -739,6 +1083,11 @@ Channel::ChannelImpl::ReadState Channel::ChannelImpl::ReadData(
   if (pipe_ == -1)
     return READ_FAILED;
 
+#if defined(IPC_USES_SHARED_MEMORY_RING)
+  if (input_ring_)
+    return ReadDataFromRing(buffer, buffer_len, bytes_read);
+#endif  // IPC_USES_SHARED_MEMORY_RING
+
   struct msghdr msg = {0};
 
   struct iovec iov = {buffer, static_cast<size_t>(buffer_len)};
@@ -756,6 +1105,9 @@ Channel::ChannelImpl::ReadState Channel::ChannelImpl::ReadData(
   } else
 #endif  // IPC_USES_READWRITE
   {
+    // input_cmsg_buf_ only has room for the descriptors that can come with
+    // kReadBufferSize bytes of messages.
+    iov.iov_len = std::min(iov.iov_len, Channel::kReadBufferSize);
     msg.msg_controllen = sizeof(input_cmsg_buf_);
     *bytes_read = HANDLE_EINTR(recvmsg(pipe_, &msg, MSG_DONTWAIT));
   }
@@ -923,10 +1275,48 @@ void Channel::ChannelImpl::HandleHelloMessage(const Message& msg) {
     CHECK(descriptor.auto_close);
   }
 #endif  // IPC_USES_READWRITE
+#if defined(IPC_USES_SHARED_MEMORY_RING)
+  // Peers that predate the shared memory transport send no offer.
+  bool peer_offers_shared_memory = false;
+  if (!msg.ReadBool(&iter, &peer_offers_shared_memory))
+    peer_offers_shared_memory = false;
+  if (output_ring_ && peer_offers_shared_memory)
+    QueueSharedMemoryMessage();
+  else
+    output_ring_.reset();
+#endif  // IPC_USES_SHARED_MEMORY_RING
   peer_pid_ = pid;
   listener()->OnChannelConnected(pid);
 }
 
+#if defined(IPC_USES_SHARED_MEMORY_RING)
+bool Channel::ChannelImpl::HandleSharedMemoryMessage(const Message& msg) {
+  // The peer may only switch if this side offered the transport, and only
+  // once.
+  if (!offer_shared_memory_ || input_ring_) {
+    LOG(ERROR) << "Unexpected shared memory message on " << pipe_name_;
+    return false;
+  }
+  PickleIterator iter(msg);
+  base::FileDescriptor descriptor;
+  if (!msg.ReadFileDescriptor(&iter, &descriptor)) {
+    LOG(ERROR) << "Shared memory message without a ring on " << pipe_name_;
+    return false;
+  }
+  uint32 capacity = 0;
+  if (!msg.ReadUInt32(&iter, &capacity))
+    capacity = 0;  // Rejected by Open(), which still closes the descriptor.
+  scoped_ptr<internal::SharedMemoryRing> ring(new internal::SharedMemoryRing);
+  if (!ring->Open(base::FileDescriptor(descriptor.fd, true), capacity)) {
+    LOG(ERROR) << "Unable to open shared memory ring on " << pipe_name_;
+    return false;
+  }
+  input_ring_.reset(ring.release());
+  DVLOG(1) << "reading from shared memory on channel @" << this;
+  return true;
+}
+#endif  // IPC_USES_SHARED_MEMORY_RING
+
 void Channel::ChannelImpl::Close() {
   // Close can be called multiple time, so we need to make sure we're
   // idempotent.
@@ -996,6 +1386,10 @@ bool Channel::GetPeerEuid(uid_t* peer_euid) const {
   return channel_impl_->GetPeerEuid(peer_euid);
 }
 
+Channel::IOStatistics Channel::GetIOStatistics() const {
+  return channel_impl_->GetIOStatistics();
+}
+
 void Channel::ResetToAcceptingConnectionState() {
   channel_impl_->ResetToAcceptingConnectionState();
 }
@@ -9,10 +9,11 @@
 
 #include <sys/socket.h>  // for CMSG macros
 
-#include <queue>
+#include <deque>
 #include <string>
 #include <vector>
 
+#include "base/memory/scoped_ptr.h"
 #include "base/message_loop/message_loop.h"
 #include "base/process/process.h"
 #include "ipc/file_descriptor_set_posix.h"
@@ -46,6 +47,22 @@
 #define IPC_USES_READWRITE 1
 #endif
 
+#if defined(IPC_USES_READWRITE)
+// With --ipc-shared-memory-transport, each peer offers a shared memory ring
+// in its HELLO message. If both offered, each side then creates a
+// SharedMemoryRing for its messages, passes it in a SHARED_MEMORY message and
+// writes all of its later message data to the ring. From then on the socket
+// only carries one-byte wakeups, sent when the other side asked for one
+// because it found the ring empty (or, for the writer, full). File
+// descriptors still go over the dedicated fd socketpair, which is why the
+// transport requires IPC_USES_READWRITE.
+#define IPC_USES_SHARED_MEMORY_RING 1
+#endif
+
+#if defined(IPC_USES_SHARED_MEMORY_RING)
+#include "ipc/ipc_shared_memory_ring.h"
+#endif
+
 namespace IPC {
 
 class Channel::ChannelImpl : public internal::ChannelReader,
@@ -67,6 +84,7 @@ class Channel::ChannelImpl : public internal::ChannelReader,
   void ResetToAcceptingConnectionState();
   base::ProcessId peer_pid() const { return peer_pid_; }
   static bool IsNamedServerInitialized(const std::string& channel_id);
+  IOStatistics GetIOStatistics() const;
 #if defined(OS_LINUX)
   static void SetGlobalPid(int pid);
 #endif  // OS_LINUX
@@ -76,6 +94,22 @@ class Channel::ChannelImpl : public internal::ChannelReader,
 
   bool ProcessOutgoingMessages();
 
+  // Returns how many messages at the front of |output_queue_| can be written
+  // together by WriteBatch(): consecutive messages without file descriptors.
+  size_t CountBatchableMessages() const;
+
+  // Writes the first |count| messages of |output_queue_| with one system call
+  // and removes those that were sent completely. Sets |*blocked| if the write
+  // could not take everything and we now wait for the pipe or the ring to
+  // drain. Returns false on channel error.
+  bool WriteBatch(size_t count, bool* blocked);
+
+  // Asks libevent to call OnFileCanWriteWithoutBlocking() once pipe_ drains.
+  void WatchForWrite();
+
+  // Handles a write error that SocketWriteErrorIsRecoverable() rejected.
+  void HandleWriteError(int fd, size_t message_size);
+
   bool AcceptConnection();
   void ClosePipeOnError();
   int GetHelloMessageProcId();
@@ -88,6 +122,23 @@ class Channel::ChannelImpl : public internal::ChannelReader,
   virtual bool WillDispatchInputMessage(Message* msg) OVERRIDE;
   virtual bool DidEmptyInputBuffers() OVERRIDE;
   virtual void HandleHelloMessage(const Message& msg) OVERRIDE;
+#if defined(IPC_USES_SHARED_MEMORY_RING)
+  virtual bool HandleSharedMemoryMessage(const Message& msg) OVERRIDE;
+
+  // Queues the SHARED_MEMORY message that hands |output_ring_| to the peer.
+  // Message data is written to the ring once the message has been sent.
+  void QueueSharedMemoryMessage();
+
+  // Writes |iov| to |output_ring_| and wakes up the peer if it asked for it.
+  // Returns the number of bytes written, or -1 if the ring is broken.
+  ssize_t WriteToRing(const struct iovec* iov, size_t iovlen);
+
+  // Implements ReadData() once the peer writes to |input_ring_|.
+  ReadState ReadDataFromRing(char* buffer, int buffer_len, int* bytes_read);
+
+  // Sends a wakeup byte over pipe_.
+  void SendWakeup();
+#endif
 
 #if defined(IPC_USES_READWRITE)
   // Reads the next message from the fd_pipe_ and appends them to the
@@ -131,6 +182,10 @@ class Channel::ChannelImpl : public internal::ChannelReader,
   // to keep track of where we are.
   size_t message_send_bytes_written_;
 
+  // See IOStatistics.
+  size_t messages_sent_;
+  size_t write_calls_;
+
   // File descriptor we're listening on for new connections if we listen
   // for connections.
   int server_listen_pipe_;
@@ -149,12 +204,31 @@ class Channel::ChannelImpl : public internal::ChannelReader,
   int remote_fd_pipe_;
 #endif
 
+#if defined(IPC_USES_SHARED_MEMORY_RING)
+  // Whether this side offers the shared memory transport. Its ring is created
+  // up front, so that the offer in the HELLO message can always be honored.
+  bool offer_shared_memory_;
+
+  // The ring this side's messages go to once |writing_to_ring_| is set, which
+  // happens after |shared_memory_message_| has been written to the socket.
+  scoped_ptr<internal::SharedMemoryRing> output_ring_;
+  Message* shared_memory_message_;
+  bool writing_to_ring_;
+
+  // The peer's ring. Once set, all message data is read from it.
+  scoped_ptr<internal::SharedMemoryRing> input_ring_;
+
+  // Set when the peer closed pipe_ while reading from |input_ring_|; the data
+  // left in the ring is still dispatched.
+  bool peer_closed_pipe_;
+#endif
+
   // The "name" of our pipe.  On Windows this is the global identifier for
   // the pipe.  On POSIX it's used as a key in a local map of file descriptors.
   std::string pipe_name_;
 
   // Messages to be sent are queued here.
-  std::queue<Message*> output_queue_;
+  std::deque<Message*> output_queue_;
 
   // We assume a worst case: kReadBufferSize bytes of messages, where each
   // message has no payload and a full complement of descriptors.
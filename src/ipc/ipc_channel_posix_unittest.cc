@@ -11,9 +11,14 @@
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <string>
+#include <vector>
+
 #include "base/basictypes.h"
+#include "base/command_line.h"
 #include "base/file_util.h"
 #include "base/files/file_path.h"
+#include "base/memory/ref_counted_memory.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/message_loop/message_loop.h"
 #include "base/path_service.h"
@@ -22,6 +27,7 @@
 #include "base/test/multiprocess_test.h"
 #include "base/test/test_timeouts.h"
 #include "ipc/ipc_listener.h"
+#include "ipc/ipc_switches.h"
 #include "ipc/unix_domain_socket_util.h"
 #include "testing/multiprocess_func_list.h"
 
@@ -94,6 +100,84 @@ class IPCChannelPosixTestListener : public IPC::Listener {
   bool quit_only_on_message_;
 };
 
+// Keeps a copy of the last message it receives and quits the run loop.
+class MessageRecordingListener : public IPC::Listener {
+ public:
+  MessageRecordingListener() {}
+  virtual ~MessageRecordingListener() {}
+
+  virtual bool OnMessageReceived(const IPC::Message& message) OVERRIDE {
+    message_.reset(new IPC::Message(message));
+    base::MessageLoopForIO::current()->QuitNow();
+    return true;
+  }
+
+  virtual void OnChannelError() OVERRIDE {
+    base::MessageLoopForIO::current()->QuitNow();
+  }
+
+  const IPC::Message* message() const { return message_.get(); }
+
+ private:
+  scoped_ptr<IPC::Message> message_;
+
+  DISALLOW_COPY_AND_ASSIGN(MessageRecordingListener);
+};
+
+// Sends every message it receives back over |channel|.
+class EchoListener : public IPC::Listener {
+ public:
+  EchoListener() : channel_(NULL) {}
+  virtual ~EchoListener() {}
+
+  void set_channel(IPC::Channel* channel) { channel_ = channel; }
+
+  virtual bool OnMessageReceived(const IPC::Message& message) OVERRIDE {
+    channel_->Send(new IPC::Message(message));
+    return true;
+  }
+
+  virtual void OnChannelError() OVERRIDE {
+    base::MessageLoopForIO::current()->QuitNow();
+  }
+
+ private:
+  IPC::Channel* channel_;
+
+  DISALLOW_COPY_AND_ASSIGN(EchoListener);
+};
+
+// Keeps the string payload of every message it receives and quits the run
+// loop once it has |expected_count| of them.
+class PayloadCollectingListener : public IPC::Listener {
+ public:
+  explicit PayloadCollectingListener(size_t expected_count)
+      : expected_count_(expected_count) {}
+  virtual ~PayloadCollectingListener() {}
+
+  virtual bool OnMessageReceived(const IPC::Message& message) OVERRIDE {
+    PickleIterator iter(message);
+    std::string payload;
+    EXPECT_TRUE(iter.ReadString(&payload));
+    payloads_.push_back(payload);
+    if (payloads_.size() == expected_count_)
+      base::MessageLoopForIO::current()->QuitNow();
+    return true;
+  }
+
+  virtual void OnChannelError() OVERRIDE {
+    base::MessageLoopForIO::current()->QuitNow();
+  }
+
+  const std::vector<std::string>& payloads() const { return payloads_; }
+
+ private:
+  size_t expected_count_;
+  std::vector<std::string> payloads_;
+
+  DISALLOW_COPY_AND_ASSIGN(PayloadCollectingListener);
+};
+
 class IPCChannelPosixTest : public base::MultiProcessTest {
  public:
   static void SetUpSocket(IPC::ChannelHandle *handle,
@@ -387,6 +471,156 @@ TEST_F(IPCChannelPosixTest, IsNamedServerInitialized) {
       connection_socket_name));
 }
 
+// Large blobs referenced by a message are written without being copied into
+// it, and arrive as if they had been copied.
+TEST_F(IPCChannelPosixTest, SendDataReferences) {
+  int fds[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  ASSERT_GE(fcntl(fds[0], F_SETFL, O_NONBLOCK), 0);
+  ASSERT_GE(fcntl(fds[1], F_SETFL, O_NONBLOCK), 0);
+  IPC::ChannelHandle server_handle("SendDataReferencesServer",
+                                   base::FileDescriptor(fds[0], true));
+  IPC::ChannelHandle client_handle("SendDataReferencesClient",
+                                   base::FileDescriptor(fds[1], true));
+  IPCChannelPosixTestListener server_listener(true);
+  MessageRecordingListener client_listener;
+  IPC::Channel server(server_handle, IPC::Channel::MODE_SERVER,
+                      &server_listener);
+  IPC::Channel client(client_handle, IPC::Channel::MODE_CLIENT,
+                      &client_listener);
+  ASSERT_TRUE(server.Connect());
+  ASSERT_TRUE(client.Connect());
+
+  // Larger than the socket buffer, so that the write is resumed part way.
+  std::string blob1(1024 * 1024 + 3, 'a');
+  std::string blob2(64 * 1024 + 1, 'b');
+  IPC::Message* message = new IPC::Message(0, 2, IPC::Message::PRIORITY_NORMAL);
+  message->WriteInt(1);
+  // The message owns references to the blobs, which are written after this
+  // scope has dropped its copies.
+  {
+    std::string copy1(blob1);
+    std::string copy2(blob2);
+    message->WriteDataReference(base::RefCountedString::TakeString(&copy1));
+    message->WriteString("between");
+    message->WriteDataReference(base::RefCountedString::TakeString(&copy2));
+  }
+  message->WriteInt(2);
+  ASSERT_TRUE(message->has_data_references());
+  ASSERT_TRUE(server.Send(message));
+  SpinRunLoop(TestTimeouts::action_max_timeout());
+
+  const IPC::Message* received = client_listener.message();
+  ASSERT_TRUE(received);
+  EXPECT_EQ(2u, received->type());
+  PickleIterator iter(*received);
+  int value = 0;
+  base::StringPiece piece;
+  EXPECT_TRUE(iter.ReadInt(&value));
+  EXPECT_EQ(1, value);
+  EXPECT_TRUE(iter.ReadStringPiece(&piece));
+  EXPECT_TRUE(piece == blob1);
+  EXPECT_TRUE(iter.ReadStringPiece(&piece));
+  EXPECT_EQ("between", piece.as_string());
+  EXPECT_TRUE(iter.ReadStringPiece(&piece));
+  EXPECT_TRUE(piece == blob2);
+  EXPECT_TRUE(iter.ReadInt(&value));
+  EXPECT_EQ(2, value);
+}
+
+// Messages queued while the server waits for the client's hello go out
+// together, and the client reads many of them per call.
+TEST_F(IPCChannelPosixTest, BatchedWrites) {
+  int fds[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  ASSERT_GE(fcntl(fds[0], F_SETFL, O_NONBLOCK), 0);
+  ASSERT_GE(fcntl(fds[1], F_SETFL, O_NONBLOCK), 0);
+  IPC::ChannelHandle server_handle("BatchedWritesServer",
+                                   base::FileDescriptor(fds[0], true));
+  IPC::ChannelHandle client_handle("BatchedWritesClient",
+                                   base::FileDescriptor(fds[1], true));
+
+  const size_t kMessageCount = 200;
+  PayloadCollectingListener server_listener(0);
+  PayloadCollectingListener client_listener(kMessageCount);
+  IPC::Channel server(server_handle, IPC::Channel::MODE_SERVER,
+                      &server_listener);
+  IPC::Channel client(client_handle, IPC::Channel::MODE_CLIENT,
+                      &client_listener);
+  ASSERT_TRUE(server.Connect());
+  ASSERT_TRUE(client.Connect());
+
+  for (size_t i = 0; i < kMessageCount; ++i) {
+    IPC::Message* message =
+        new IPC::Message(0, 2, IPC::Message::PRIORITY_NORMAL);
+    message->WriteString(std::string(i % 50, 'a' + i % 26));
+    ASSERT_TRUE(server.Send(message));
+  }
+  SpinRunLoop(TestTimeouts::action_max_timeout());
+
+  ASSERT_EQ(kMessageCount, client_listener.payloads().size());
+  for (size_t i = 0; i < kMessageCount; ++i) {
+    EXPECT_EQ(std::string(i % 50, 'a' + i % 26),
+              client_listener.payloads()[i]);
+  }
+
+  // The server also sent its hello.
+  IPC::Channel::IOStatistics server_statistics = server.GetIOStatistics();
+  EXPECT_EQ(kMessageCount + 1, server_statistics.messages_sent);
+  EXPECT_LT(server_statistics.write_calls, kMessageCount / 10);
+  IPC::Channel::IOStatistics client_statistics = client.GetIOStatistics();
+  EXPECT_EQ(kMessageCount, client_statistics.messages_received);
+  EXPECT_LT(client_statistics.read_calls, kMessageCount / 10);
+}
+
+// With the shared memory transport, messages of any size make the round trip
+// intact, including ones larger than the ring.
+TEST_F(IPCChannelPosixTest, SharedMemoryTransport) {
+  int fds[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  ASSERT_GE(fcntl(fds[0], F_SETFL, O_NONBLOCK), 0);
+  ASSERT_GE(fcntl(fds[1], F_SETFL, O_NONBLOCK), 0);
+  IPC::ChannelHandle server_handle("SharedMemoryTransportServer",
+                                   base::FileDescriptor(fds[0], true));
+  IPC::ChannelHandle client_handle("SharedMemoryTransportClient",
+                                   base::FileDescriptor(fds[1], true));
+
+  std::vector<std::string> payloads;
+  const size_t kSizes[] = { 12, 4000, 300 * 1024, 1024 * 1024 + 3 };
+  for (size_t i = 0; i < arraysize(kSizes); ++i)
+    payloads.push_back(std::string(kSizes[i], 'a' + i));
+  // Many small messages exercise the wakeups.
+  for (int i = 0; i < 1000; ++i)
+    payloads.push_back(std::string(100 + i % 7, 'k' + i % 5));
+
+  PayloadCollectingListener server_listener(payloads.size());
+  EchoListener client_listener;
+  // The channels read the switch when they are created.
+  CommandLine saved_command_line(*CommandLine::ForCurrentProcess());
+  CommandLine::ForCurrentProcess()->AppendSwitch(
+      switches::kIPCSharedMemoryTransport);
+  IPC::Channel server(server_handle, IPC::Channel::MODE_SERVER,
+                      &server_listener);
+  IPC::Channel client(client_handle, IPC::Channel::MODE_CLIENT,
+                      &client_listener);
+  *CommandLine::ForCurrentProcess() = saved_command_line;
+  client_listener.set_channel(&client);
+  ASSERT_TRUE(server.Connect());
+  ASSERT_TRUE(client.Connect());
+
+  for (size_t i = 0; i < payloads.size(); ++i) {
+    IPC::Message* message =
+        new IPC::Message(0, 2, IPC::Message::PRIORITY_NORMAL);
+    message->WriteString(payloads[i]);
+    ASSERT_TRUE(server.Send(message));
+  }
+  SpinRunLoop(TestTimeouts::action_max_timeout());
+
+  ASSERT_EQ(payloads.size(), server_listener.payloads().size());
+  for (size_t i = 0; i < payloads.size(); ++i)
+    EXPECT_TRUE(payloads[i] == server_listener.payloads()[i]) << i;
+}
+
 // A long running process that connects to us
 MULTIPROCESS_TEST_MAIN(IPCChannelPosixTestConnectionProc) {
   base::MessageLoopForIO message_loop;
@@ -11,7 +11,10 @@
 namespace IPC {
 namespace internal {
 
-ChannelReader::ChannelReader(Listener* listener) : listener_(listener) {
+ChannelReader::ChannelReader(Listener* listener)
+    : listener_(listener),
+      messages_received_(0),
+      read_calls_(0) {
   memset(input_buf_, 0, sizeof(input_buf_));
 }
 
@@ -21,8 +24,9 @@ ChannelReader::~ChannelReader() {
 bool ChannelReader::ProcessIncomingMessages() {
   while (true) {
     int bytes_read = 0;
-    ReadState read_state = ReadData(input_buf_, Channel::kReadBufferSize,
+    ReadState read_state = ReadData(input_buf_, kInputBufferSize,
                                     &bytes_read);
+    ++read_calls_;
     if (read_state == READ_FAILED)
       return false;
     if (read_state == READ_PENDING)
@@ -43,6 +47,16 @@ bool ChannelReader::IsHelloMessage(const Message& m) const {
          m.type() == Channel::HELLO_MESSAGE_TYPE;
 }
 
+bool ChannelReader::IsSharedMemoryMessage(const Message& m) const {
+  return m.routing_id() == MSG_ROUTING_NONE &&
+         m.type() == Channel::SHARED_MEMORY_MESSAGE_TYPE;
+}
+
+bool ChannelReader::HandleSharedMemoryMessage(const Message& msg) {
+  LOG(ERROR) << "Unexpected shared memory message";
+  return false;
+}
+
 bool ChannelReader::DispatchInputData(const char* input_data,
                                       int input_data_len) {
   const char* p;
@@ -84,10 +98,21 @@ bool ChannelReader::DispatchInputData(const char* input_data,
                    "line", IPC_MESSAGE_ID_LINE(m.type()));
 #endif
       m.TraceMessageEnd();
-      if (IsHelloMessage(m))
+      if (IsHelloMessage(m)) {
         HandleHelloMessage(m);
-      else
+      } else if (IsSharedMemoryMessage(m)) {
+        if (!HandleSharedMemoryMessage(m)) {
+          input_overflow_buf_.clear();
+          return false;
+        }
+        // The rest of the pipe data only signals that the shared memory has
+        // changed.
+        p = end;
+        break;
+      } else {
+        ++messages_received_;
         listener_->OnMessageReceived(m);
+      }
       p = message_tail;
     } else {
       // Last message is partial.
@@ -46,6 +46,15 @@ class ChannelReader {
   // set-up.
   bool IsHelloMessage(const Message& m) const;
 
+  // Returns true if the given message announces that the peer writes all of
+  // its later messages to shared memory.
+  bool IsSharedMemoryMessage(const Message& m) const;
+
+  // The number of messages passed to the listener, and of ReadData() calls
+  // made by ProcessIncomingMessages().
+  size_t messages_received() const { return messages_received_; }
+  size_t read_calls() const { return read_calls_; }
+
  protected:
   enum ReadState { READ_SUCCEEDED, READ_FAILED, READ_PENDING };
 
@@ -79,6 +88,11 @@ class ChannelReader {
   // Handles the first message sent over the pipe which contains setup info.
   virtual void HandleHelloMessage(const Message& msg) = 0;
 
+  // Handles the shared memory message. Any data read from the pipe after it
+  // is not message data and is dropped. Returns false on channel error, which
+  // is the default for channels that never offer shared memory.
+  virtual bool HandleSharedMemoryMessage(const Message& msg);
+
  private:
   // Takes the given data received from the IPC channel and dispatches any
   // fully completed messages.
@@ -89,13 +103,18 @@ class ChannelReader {
   Listener* listener_;
 
   // We read from the pipe into this buffer. Managed by DispatchInputData, do
-  // not access directly outside that function.
-  char input_buf_[Channel::kReadBufferSize];
+  // not access directly outside that function. It holds many small messages,
+  // so that DispatchInputData can dispatch a burst of them after one read.
+  static const size_t kInputBufferSize = 64 * 1024;
+  char input_buf_[kInputBufferSize];
 
   // Large messages that span multiple pipe buffers, get built-up using
   // this buffer.
   std::string input_overflow_buf_;
 
+  size_t messages_received_;
+  size_t read_calls_;
+
   DISALLOW_COPY_AND_ASSIGN(ChannelReader);
 };
 
@@ -385,6 +385,7 @@ bool Channel::ChannelImpl::ProcessOutgoingMessages(
 
   // Write to pipe...
   Message* m = output_queue_.front();
+  m->Flatten();
   DCHECK(m->size() <= INT_MAX);
   BOOL ok = WriteFile(pipe_,
                       m->data(),
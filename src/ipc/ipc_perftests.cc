@@ -8,6 +8,7 @@
 #include <string>
 
 #include "base/basictypes.h"
+#include "base/command_line.h"
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/pickle.h"
@@ -20,6 +21,7 @@
 #include "ipc/ipc_descriptors.h"
 #include "ipc/ipc_message_utils.h"
 #include "ipc/ipc_sender.h"
+#include "ipc/ipc_switches.h"
 #include "ipc/ipc_test_base.h"
 
 namespace {
@@ -29,6 +31,13 @@ namespace {
 // TODO(brettw): Make this test run by default.
 
 class IPCChannelPerfTest : public IPCTestBase {
+ protected:
+  // Bounces messages of 12 bytes to 1 MB between the processes. The number of
+  // messages shrinks with their size so that every size moves about the same
+  // amount of data. Up to |max_burst_size| messages are in flight at once,
+  // which lets the channel write and read several of them per system call.
+  // |label| prefixes the names of the results.
+  void RunPerformanceTest(const std::string& label, int max_burst_size);
 };
 
 // This class simply collects stats about abstract "events" (each of which has a
@@ -59,6 +68,11 @@ class EventTimeTracker {
             << max_duration_.InMillisecondsF() << " ms";
   }
 
+  base::TimeDelta average_duration() const {
+    return count_ ? total_duration_ / static_cast<int64>(count_)
+                  : base::TimeDelta();
+  }
+
   void Reset() {
     count_ = 0;
     total_duration_ = base::TimeDelta();
@@ -137,11 +151,16 @@ class ChannelReflectorListener : public IPC::Listener {
 
 class PerformanceChannelListener : public IPC::Listener {
  public:
-  PerformanceChannelListener()
-      : channel_(NULL),
+  // |label| prefixes the names of the logged results.
+  explicit PerformanceChannelListener(const std::string& label)
+      : label_(label),
+        channel_(NULL),
         msg_count_(0),
         msg_size_(0),
+        burst_size_(0),
         count_down_(0),
+        unsent_(0),
+        in_flight_(0),
         latency_tracker_("Server messages") {
     VLOG(1) << "Server listener up";
   }
@@ -155,12 +174,16 @@ class PerformanceChannelListener : public IPC::Listener {
     channel_ = channel;
   }
 
-  // Call this before running the message loop.
-  void SetTestParams(int msg_count, size_t msg_size) {
+  // Call this before running the message loop. The messages are sent
+  // |burst_size| at a time; the next burst goes out once all replies to the
+  // previous one have arrived.
+  void SetTestParams(int msg_count, size_t msg_size, int burst_size) {
     DCHECK_EQ(0, count_down_);
     msg_count_ = msg_count;
     msg_size_ = msg_size;
+    burst_size_ = burst_size;
     count_down_ = msg_count_;
+    unsent_ = msg_count_;
     payload_ = std::string(msg_size_, 'a');
   }
 
@@ -182,9 +205,13 @@ class PerformanceChannelListener : public IPC::Listener {
       // Start timing on hello.
       latency_tracker_.Reset();
       DCHECK(!perf_logger_.get());
-      std::string test_name = base::StringPrintf(
-          "IPC_Perf_%dx_%u", msg_count_, static_cast<unsigned>(msg_size_));
-      perf_logger_.reset(new PerfTimeLogger(test_name.c_str()));
+      test_name_ = base::StringPrintf("%s_%dx_%u", label_.c_str(), msg_count_,
+                                      static_cast<unsigned>(msg_size_));
+      perf_logger_.reset(new PerfTimeLogger(test_name_.c_str()));
+      start_time_ = now;
+#if defined(OS_POSIX)
+      start_statistics_ = channel_->GetIOStatistics();
+#endif
     } else {
       DCHECK_EQ(payload_.size(), reflected_payload.size());
 
@@ -193,49 +220,101 @@ class PerformanceChannelListener : public IPC::Listener {
 
       CHECK(count_down_ > 0);
       count_down_--;
+      in_flight_--;
       if (count_down_ == 0) {
         perf_logger_.reset();  // Stop the perf timer now.
         latency_tracker_.ShowResults();
+        LogResults(now - start_time_);
         base::MessageLoop::current()->QuitWhenIdle();
         return true;
       }
+      if (in_flight_ > 0)
+        return true;
     }
 
-    IPC::Message* msg = new IPC::Message(0, 2, IPC::Message::PRIORITY_NORMAL);
-    msg->WriteInt64(base::TimeTicks::Now().ToInternalValue());
-    msg->WriteInt(count_down_);
-    msg->WriteString(payload_);
-    channel_->Send(msg);
+    SendBurst();
     return true;
   }
 
  private:
+  void SendBurst() {
+    int count = std::min(burst_size_, unsent_);
+    for (int i = 0; i < count; ++i) {
+      IPC::Message* msg =
+          new IPC::Message(0, 2, IPC::Message::PRIORITY_NORMAL);
+      msg->WriteInt64(base::TimeTicks::Now().ToInternalValue());
+      msg->WriteInt(unsent_--);
+      msg->WriteString(payload_);
+      channel_->Send(msg);
+    }
+    in_flight_ += count;
+  }
+
+  // Logs the payload throughput, counting both directions, and the average
+  // one-way latency.
+  void LogResults(base::TimeDelta elapsed) {
+    double megabytes = 2.0 * msg_count_ * msg_size_ / (1024 * 1024);
+    LogPerfResult((test_name_ + "_throughput").c_str(),
+                  megabytes / elapsed.InSecondsF(), "MB/s");
+    LogPerfResult((test_name_ + "_latency").c_str(),
+                  latency_tracker_.average_duration().InMicroseconds(), "us");
+#if defined(OS_POSIX)
+    // On the ring transport, a ring access counts as a call.
+    IPC::Channel::IOStatistics statistics = channel_->GetIOStatistics();
+    LogPerfResult((test_name_ + "_msgs_per_write").c_str(),
+                  static_cast<double>(statistics.messages_sent -
+                                      start_statistics_.messages_sent) /
+                      (statistics.write_calls - start_statistics_.write_calls),
+                  "msgs/syscall");
+    LogPerfResult((test_name_ + "_msgs_per_read").c_str(),
+                  static_cast<double>(statistics.messages_received -
+                                      start_statistics_.messages_received) /
+                      (statistics.read_calls - start_statistics_.read_calls),
+                  "msgs/syscall");
+#endif
+  }
+
+  const std::string label_;
   IPC::Channel* channel_;
   int msg_count_;
   size_t msg_size_;
+  int burst_size_;
 
   int count_down_;
+  int unsent_;
+  int in_flight_;
   std::string payload_;
   EventTimeTracker latency_tracker_;
+  std::string test_name_;
+  base::TimeTicks start_time_;
+#if defined(OS_POSIX)
+  IPC::Channel::IOStatistics start_statistics_;
+#endif
   scoped_ptr<PerfTimeLogger> perf_logger_;
 };
 
-TEST_F(IPCChannelPerfTest, Performance) {
+void IPCChannelPerfTest::RunPerformanceTest(const std::string& label,
+                                            int max_burst_size) {
   Init("PerformanceClient");
 
   // Set up IPC channel and start client.
-  PerformanceChannelListener listener;
+  PerformanceChannelListener listener(label);
   CreateChannel(&listener);
   listener.Init(channel());
   ASSERT_TRUE(ConnectChannel());
   ASSERT_TRUE(StartClient());
 
-  const size_t kMsgSizeBase = 12;
-  const int kMsgSizeMaxExp = 5;
-  int msg_count = 100000;
-  size_t msg_size = kMsgSizeBase;
-  for (int i = 1; i <= kMsgSizeMaxExp; i++) {
-    listener.SetTestParams(msg_count, msg_size);
+  const size_t kMsgSizes[] = { 12, 144, 1728, 20736, 248832, 1024 * 1024 };
+  const size_t kBytesPerSize = 256 * 1024 * 1024;
+  const int kMaxMsgCount = 100000;
+  // Keeps large messages from piling up in the queues.
+  const size_t kMaxBytesPerBurst = 4 * 1024 * 1024;
+  for (size_t i = 0; i < arraysize(kMsgSizes); i++) {
+    int msg_count = static_cast<int>(
+        std::min<size_t>(kMaxMsgCount, kBytesPerSize / kMsgSizes[i]));
+    int burst_size = static_cast<int>(std::max<size_t>(1, std::min<size_t>(
+        max_burst_size, kMaxBytesPerBurst / kMsgSizes[i])));
+    listener.SetTestParams(msg_count, kMsgSizes[i], burst_size);
 
     // This initial message will kick-start the ping-pong of messages.
     IPC::Message* message =
@@ -247,8 +326,6 @@ TEST_F(IPCChannelPerfTest, Performance) {
 
     // Run message loop.
     base::MessageLoop::current()->Run();
-
-    msg_size *= kMsgSizeBase;
   }
 
   // Send quit message.
@@ -262,6 +339,34 @@ TEST_F(IPCChannelPerfTest, Performance) {
   DestroyChannel();
 }
 
+TEST_F(IPCChannelPerfTest, Performance) {
+  RunPerformanceTest("IPC_Perf", 1);
+}
+
+TEST_F(IPCChannelPerfTest, BurstPerformance) {
+  RunPerformanceTest("IPC_Perf_Burst", 100);
+}
+
+#if defined(OS_POSIX) && !defined(OS_MACOSX)
+// The same over the shared memory transport. The client inherits the switch
+// on its command line.
+TEST_F(IPCChannelPerfTest, SharedMemoryPerformance) {
+  CommandLine saved_command_line(*CommandLine::ForCurrentProcess());
+  CommandLine::ForCurrentProcess()->AppendSwitch(
+      switches::kIPCSharedMemoryTransport);
+  RunPerformanceTest("IPC_Perf_SharedMemory", 1);
+  *CommandLine::ForCurrentProcess() = saved_command_line;
+}
+
+TEST_F(IPCChannelPerfTest, SharedMemoryBurstPerformance) {
+  CommandLine saved_command_line(*CommandLine::ForCurrentProcess());
+  CommandLine::ForCurrentProcess()->AppendSwitch(
+      switches::kIPCSharedMemoryTransport);
+  RunPerformanceTest("IPC_Perf_SharedMemory_Burst", 100);
+  *CommandLine::ForCurrentProcess() = saved_command_line;
+}
+#endif
+
 // This message loop bounces all messages back to the sender.
 MULTIPROCESS_IPC_TEST_CLIENT_MAIN(PerformanceClient) {
   base::MessageLoopForIO main_message_loop;
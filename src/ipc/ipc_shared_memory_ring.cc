@@ -0,0 +1,188 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ipc/ipc_shared_memory_ring.h"
+
+#include <string.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+namespace IPC {
+namespace internal {
+
+namespace {
+
+// The data follows the header at this offset.
+const size_t kHeaderSize = 256;
+
+COMPILE_ASSERT(SharedMemoryRing::kMaxCapacity <= kuint32max - kHeaderSize,
+               ring_size_must_not_overflow);
+
+bool IsValidCapacity(size_t capacity) {
+  return capacity >= SharedMemoryRing::kMinCapacity &&
+         capacity <= SharedMemoryRing::kMaxCapacity &&
+         (capacity & (capacity - 1)) == 0;
+}
+
+}  // namespace
+
+// Lives at the start of the shared memory. The positions count the bytes
+// written and read so far, modulo 2^32; each is on its own cache line so that
+// the two sides do not contend for it.
+struct SharedMemoryRing::Header {
+  volatile base::subtle::Atomic32 write_position;
+  char padding1[64 - sizeof(base::subtle::Atomic32)];
+  volatile base::subtle::Atomic32 read_position;
+  char padding2[64 - sizeof(base::subtle::Atomic32)];
+  // Set by a side that ran out of data or space and wants to be woken up.
+  volatile base::subtle::Atomic32 reader_waiting;
+  volatile base::subtle::Atomic32 writer_waiting;
+};
+
+SharedMemoryRing::SharedMemoryRing()
+    : header_(NULL),
+      data_(NULL),
+      capacity_(0),
+      position_(0) {
+  COMPILE_ASSERT(sizeof(Header) <= kHeaderSize, ring_header_too_large);
+}
+
+SharedMemoryRing::~SharedMemoryRing() {
+}
+
+bool SharedMemoryRing::Create(size_t capacity) {
+  DCHECK(!header_);
+  DCHECK(IsValidCapacity(capacity));
+  shared_memory_.reset(new base::SharedMemory);
+  if (!shared_memory_->CreateAnonymous(kHeaderSize + capacity))
+    return false;
+  if (!Map(capacity))
+    return false;
+  // Anonymous shared memory starts out zeroed, which is an empty ring.
+  return true;
+}
+
+bool SharedMemoryRing::Open(const base::SharedMemoryHandle& handle,
+                            size_t capacity) {
+  DCHECK(!header_);
+  shared_memory_.reset(new base::SharedMemory(handle, false));
+  if (!IsValidCapacity(capacity)) {
+    LOG(ERROR) << "Invalid shared memory ring capacity " << capacity;
+    return false;
+  }
+  // Touching pages beyond the end of the file raises SIGBUS, so the peer must
+  // not be able to claim more capacity than it backed. The capacity limit
+  // keeps the sum from overflowing.
+  struct stat st;
+  if (fstat(handle.fd, &st) != 0 || st.st_size < 0 ||
+      static_cast<uint64>(st.st_size) < kHeaderSize + capacity) {
+    LOG(ERROR) << "Shared memory ring smaller than its capacity " << capacity;
+    return false;
+  }
+  return Map(capacity);
+}
+
+bool SharedMemoryRing::Map(size_t capacity) {
+  if (!shared_memory_->Map(kHeaderSize + capacity))
+    return false;
+  header_ = static_cast<Header*>(shared_memory_->memory());
+  data_ = static_cast<char*>(shared_memory_->memory()) + kHeaderSize;
+  capacity_ = capacity;
+  return true;
+}
+
+bool SharedMemoryRing::Write(const char* data, size_t size, size_t* written) {
+  DCHECK(header_);
+  // The acquire load orders the reader's copies out of the ring before the
+  // writes below that may overwrite the same bytes.
+  uint32 read_position = static_cast<uint32>(
+      base::subtle::Acquire_Load(&header_->read_position));
+  uint32 used = position_ - read_position;
+  if (used > capacity_)
+    return false;
+
+  size_t count = std::min(size, capacity_ - used);
+  size_t offset = position_ & (capacity_ - 1);
+  size_t first = std::min(count, capacity_ - offset);
+  memcpy(data_ + offset, data, first);
+  memcpy(data_, data + first, count - first);
+
+  position_ += static_cast<uint32>(count);
+  base::subtle::Release_Store(&header_->write_position,
+                              static_cast<base::subtle::Atomic32>(position_));
+  *written = count;
+  return true;
+}
+
+bool SharedMemoryRing::WaitForSpace() {
+  DCHECK(header_);
+  base::subtle::NoBarrier_Store(&header_->writer_waiting, 1);
+  // Pairs with the barrier in TakeWriterWakeup(): either the reader sees the
+  // request, or this side sees the space it freed.
+  base::subtle::MemoryBarrier();
+  uint32 read_position = static_cast<uint32>(
+      base::subtle::Acquire_Load(&header_->read_position));
+  if (position_ - read_position >= capacity_)
+    return false;
+  base::subtle::NoBarrier_Store(&header_->writer_waiting, 0);
+  return true;
+}
+
+bool SharedMemoryRing::TakeReaderWakeup() {
+  DCHECK(header_);
+  base::subtle::MemoryBarrier();
+  if (!base::subtle::NoBarrier_Load(&header_->reader_waiting))
+    return false;
+  return base::subtle::NoBarrier_AtomicExchange(&header_->reader_waiting,
+                                                0) != 0;
+}
+
+bool SharedMemoryRing::Read(char* buffer, size_t size, size_t* read) {
+  DCHECK(header_);
+  uint32 write_position = static_cast<uint32>(
+      base::subtle::Acquire_Load(&header_->write_position));
+  uint32 available = write_position - position_;
+  if (available > capacity_)
+    return false;
+
+  size_t count = std::min(size, static_cast<size_t>(available));
+  size_t offset = position_ & (capacity_ - 1);
+  size_t first = std::min(count, capacity_ - offset);
+  memcpy(buffer, data_ + offset, first);
+  memcpy(buffer + first, data_, count - first);
+
+  position_ += static_cast<uint32>(count);
+  base::subtle::Release_Store(&header_->read_position,
+                              static_cast<base::subtle::Atomic32>(position_));
+  *read = count;
+  return true;
+}
+
+bool SharedMemoryRing::WaitForData() {
+  DCHECK(header_);
+  base::subtle::NoBarrier_Store(&header_->reader_waiting, 1);
+  // Pairs with the barrier in TakeReaderWakeup().
+  base::subtle::MemoryBarrier();
+  uint32 write_position = static_cast<uint32>(
+      base::subtle::Acquire_Load(&header_->write_position));
+  if (write_position == position_)
+    return false;
+  base::subtle::NoBarrier_Store(&header_->reader_waiting, 0);
+  return true;
+}
+
+bool SharedMemoryRing::TakeWriterWakeup() {
+  DCHECK(header_);
+  base::subtle::MemoryBarrier();
+  if (!base::subtle::NoBarrier_Load(&header_->writer_waiting))
+    return false;
+  return base::subtle::NoBarrier_AtomicExchange(&header_->writer_waiting,
+                                                0) != 0;
+}
+
+}  // namespace internal
+}  // namespace IPC
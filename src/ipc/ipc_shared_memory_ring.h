@@ -0,0 +1,98 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IPC_IPC_SHARED_MEMORY_RING_H_
+#define IPC_IPC_SHARED_MEMORY_RING_H_
+
+#include "base/atomicops.h"
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/shared_memory.h"
+#include "ipc/ipc_export.h"
+
+namespace IPC {
+namespace internal {
+
+// A single-producer single-consumer byte ring in shared memory. One process
+// creates the ring and writes to it; the other opens it from the handle and
+// reads from it. Both sides may run concurrently without locks.
+//
+// The ring does not block. When a side runs out of data or space it calls
+// WaitForData() or WaitForSpace(), and the other side learns from
+// TakeReaderWakeup() or TakeWriterWakeup() that it has to signal it through
+// some other means, e.g. a socket.
+//
+// The memory is shared with a possibly compromised process, so every value
+// read from it is checked. A ring whose positions are inconsistent is
+// reported as broken.
+class IPC_EXPORT SharedMemoryRing {
+ public:
+  // Limits for the capacity passed to Create() and Open().
+  static const size_t kMinCapacity = 4 * 1024;
+  static const size_t kMaxCapacity = 16 * 1024 * 1024;
+
+  SharedMemoryRing();
+  ~SharedMemoryRing();
+
+  // Creates a ring with room for |capacity| bytes, which must be a power of
+  // two within the limits above. The caller becomes the writer.
+  bool Create(size_t capacity);
+
+  // Maps the ring created by another process as its reader. Takes ownership
+  // of |handle| even on failure. Fails if |capacity| is not one that Create()
+  // accepts.
+  bool Open(const base::SharedMemoryHandle& handle, size_t capacity);
+
+  // The handle to pass to the reader. Owned by this object.
+  base::SharedMemoryHandle handle() const { return shared_memory_->handle(); }
+
+  size_t capacity() const { return capacity_; }
+
+  // Writer side. Copies as many bytes of |data| as fit and stores the count in
+  // |*written|. Returns false if the ring is broken.
+  bool Write(const char* data, size_t size, size_t* written);
+
+  // Writer side. Asks the reader for a wakeup once it has freed space. Returns
+  // true if space became free in the meantime; the request may then still
+  // cause a spurious wakeup.
+  bool WaitForSpace();
+
+  // Writer side. Returns true, once, if the reader asked to be woken up
+  // because the ring was empty. Call after Write().
+  bool TakeReaderWakeup();
+
+  // Reader side. Copies up to |size| bytes into |buffer| and stores the count
+  // in |*read|. Returns false if the ring is broken.
+  bool Read(char* buffer, size_t size, size_t* read);
+
+  // Reader side. Asks the writer for a wakeup once it has written more data.
+  // Returns true if data arrived in the meantime.
+  bool WaitForData();
+
+  // Reader side. Returns true, once, if the writer asked to be woken up
+  // because the ring was full. Call after Read().
+  bool TakeWriterWakeup();
+
+ private:
+  struct Header;
+
+  // Maps |shared_memory_| and sets up the pointers for |capacity|.
+  bool Map(size_t capacity);
+
+  scoped_ptr<base::SharedMemory> shared_memory_;
+  Header* header_;
+  char* data_;
+  size_t capacity_;
+
+  // This side's position. The copy in shared memory is only published, never
+  // read back, so the other process cannot move it.
+  uint32 position_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedMemoryRing);
+};
+
+}  // namespace internal
+}  // namespace IPC
+
+#endif  // IPC_IPC_SHARED_MEMORY_RING_H_
@@ -0,0 +1,174 @@
+// Copyright 2013 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ipc/ipc_shared_memory_ring.h"
+
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/posix/eintr_wrapper.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace IPC {
+namespace internal {
+namespace {
+
+const size_t kCapacity = SharedMemoryRing::kMinCapacity;
+
+// Opens |writer|'s ring a second time, as the other process would.
+bool OpenReader(const SharedMemoryRing& writer, SharedMemoryRing* reader) {
+  int fd = HANDLE_EINTR(dup(writer.handle().fd));
+  return fd >= 0 &&
+         reader->Open(base::FileDescriptor(fd, true), writer.capacity());
+}
+
+std::string MakeData(size_t size, char seed) {
+  std::string data(size, 0);
+  for (size_t i = 0; i < size; ++i)
+    data[i] = static_cast<char>(seed + i % 31);
+  return data;
+}
+
+TEST(SharedMemoryRingTest, WriteAndReadAcrossTheEnd) {
+  SharedMemoryRing writer;
+  ASSERT_TRUE(writer.Create(kCapacity));
+  SharedMemoryRing reader;
+  ASSERT_TRUE(OpenReader(writer, &reader));
+
+  // Each round moves the positions by an odd amount so that the copies wrap
+  // around the end of the ring at different offsets.
+  std::vector<char> buffer(kCapacity);
+  for (int round = 0; round < 10; ++round) {
+    std::string data = MakeData(kCapacity / 2 + 13 * round + 1, 'a' + round);
+    size_t written = 0;
+    ASSERT_TRUE(writer.Write(data.data(), data.size(), &written));
+    ASSERT_EQ(data.size(), written);
+
+    size_t read = 0;
+    ASSERT_TRUE(reader.Read(&buffer[0], buffer.size(), &read));
+    ASSERT_EQ(data.size(), read);
+    EXPECT_EQ(data, std::string(&buffer[0], read));
+  }
+}
+
+TEST(SharedMemoryRingTest, PartialWritesAndReads) {
+  SharedMemoryRing writer;
+  ASSERT_TRUE(writer.Create(kCapacity));
+  SharedMemoryRing reader;
+  ASSERT_TRUE(OpenReader(writer, &reader));
+
+  std::string data = MakeData(kCapacity + 100, 'x');
+  size_t written = 0;
+  ASSERT_TRUE(writer.Write(data.data(), data.size(), &written));
+  EXPECT_EQ(kCapacity, written);
+  ASSERT_TRUE(writer.Write(data.data(), data.size(), &written));
+  EXPECT_EQ(0u, written);
+
+  char buffer[100];
+  size_t read = 0;
+  ASSERT_TRUE(reader.Read(buffer, sizeof(buffer), &read));
+  ASSERT_EQ(sizeof(buffer), read);
+  EXPECT_EQ(data.substr(0, sizeof(buffer)), std::string(buffer, read));
+
+  ASSERT_TRUE(writer.Write(data.data() + kCapacity, 100, &written));
+  EXPECT_EQ(100u, written);
+
+  std::vector<char> rest(2 * kCapacity);
+  ASSERT_TRUE(reader.Read(&rest[0], rest.size(), &read));
+  ASSERT_EQ(kCapacity, read);
+  EXPECT_EQ(data.substr(sizeof(buffer)), std::string(&rest[0], read));
+  ASSERT_TRUE(reader.Read(&rest[0], rest.size(), &read));
+  EXPECT_EQ(0u, read);
+}
+
+TEST(SharedMemoryRingTest, Wakeups) {
+  SharedMemoryRing writer;
+  ASSERT_TRUE(writer.Create(kCapacity));
+  SharedMemoryRing reader;
+  ASSERT_TRUE(OpenReader(writer, &reader));
+
+  // Nothing asked for a wakeup yet.
+  EXPECT_FALSE(writer.TakeReaderWakeup());
+  EXPECT_FALSE(reader.TakeWriterWakeup());
+
+  // The reader finds the ring empty and asks to be woken up; the writer is
+  // told so exactly once.
+  EXPECT_FALSE(reader.WaitForData());
+  size_t written = 0;
+  ASSERT_TRUE(writer.Write("abc", 3, &written));
+  EXPECT_TRUE(writer.TakeReaderWakeup());
+  EXPECT_FALSE(writer.TakeReaderWakeup());
+  // Data is there now, so no wakeup is needed.
+  EXPECT_TRUE(reader.WaitForData());
+  EXPECT_FALSE(writer.TakeReaderWakeup());
+
+  // The same for a full ring.
+  std::string data = MakeData(kCapacity, 'a');
+  ASSERT_TRUE(writer.Write(data.data(), data.size(), &written));
+  EXPECT_FALSE(writer.WaitForSpace());
+  char buffer[16];
+  size_t read = 0;
+  ASSERT_TRUE(reader.Read(buffer, sizeof(buffer), &read));
+  EXPECT_TRUE(reader.TakeWriterWakeup());
+  EXPECT_FALSE(reader.TakeWriterWakeup());
+  EXPECT_TRUE(writer.WaitForSpace());
+  EXPECT_FALSE(reader.TakeWriterWakeup());
+}
+
+TEST(SharedMemoryRingTest, RejectsInvalidCapacity) {
+  SharedMemoryRing writer;
+  ASSERT_TRUE(writer.Create(kCapacity));
+
+  int fd = HANDLE_EINTR(dup(writer.handle().fd));
+  ASSERT_GE(fd, 0);
+  SharedMemoryRing not_power_of_two;
+  EXPECT_FALSE(not_power_of_two.Open(base::FileDescriptor(fd, true),
+                                     kCapacity - 1));
+
+  fd = HANDLE_EINTR(dup(writer.handle().fd));
+  ASSERT_GE(fd, 0);
+  SharedMemoryRing too_large;
+  EXPECT_FALSE(too_large.Open(base::FileDescriptor(fd, true),
+                              SharedMemoryRing::kMaxCapacity * 2));
+}
+
+// A peer that backs the ring with less memory than it claims must not make
+// the reader fault on the missing pages.
+TEST(SharedMemoryRingTest, RejectsTooSmallMemory) {
+  base::SharedMemory small;
+  ASSERT_TRUE(small.CreateAnonymous(kCapacity));
+  int fd = HANDLE_EINTR(dup(small.handle().fd));
+  ASSERT_GE(fd, 0);
+  SharedMemoryRing reader;
+  EXPECT_FALSE(reader.Open(base::FileDescriptor(fd, true), kCapacity));
+}
+
+// A peer that scribbles over the positions cannot make the other side read or
+// write outside of the ring.
+TEST(SharedMemoryRingTest, DetectsCorruptPositions) {
+  SharedMemoryRing writer;
+  ASSERT_TRUE(writer.Create(kCapacity));
+  SharedMemoryRing reader;
+  ASSERT_TRUE(OpenReader(writer, &reader));
+
+  int fd = HANDLE_EINTR(dup(writer.handle().fd));
+  ASSERT_GE(fd, 0);
+  base::SharedMemory raw(base::FileDescriptor(fd, true), false);
+  ASSERT_TRUE(raw.Map(sizeof(base::subtle::Atomic32)));
+  // The write position is the first field of the header.
+  volatile base::subtle::Atomic32* write_position =
+      static_cast<volatile base::subtle::Atomic32*>(raw.memory());
+
+  *write_position = static_cast<base::subtle::Atomic32>(kCapacity + 1);
+  char buffer[16];
+  size_t read = 0;
+  EXPECT_FALSE(reader.Read(buffer, sizeof(buffer), &read));
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace IPC
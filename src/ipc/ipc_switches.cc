@@ -20,5 +20,9 @@ const char kProcessChannelID[]              = "channel";
 // kDebugOnStart flag passed on or not.
 const char kDebugChildren[]                 = "debug-children";
 
+// Offers peers a shared memory ring per direction instead of sending message
+// data through the channel's socket. Only used if both peers offer it.
+const char kIPCSharedMemoryTransport[]      = "ipc-shared-memory-transport";
+
 }  // namespace switches
 
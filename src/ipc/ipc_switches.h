@@ -13,6 +13,7 @@ namespace switches {
 
 IPC_EXPORT extern const char kProcessChannelID[];
 IPC_EXPORT extern const char kDebugChildren[];
+IPC_EXPORT extern const char kIPCSharedMemoryTransport[];
 
 }  // namespace switches
 